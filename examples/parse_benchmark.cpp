@@ -0,0 +1,645 @@
+/*
+ *  parse_benchmark.cpp
+ *  MonkSVG
+ *
+ *  Parser throughput benchmarks. Needs no window or rendering backend. The
+ *  checks that the parser reads correctly are in parse_tests.cpp.
+ *
+ *  usage: parse_benchmark [data directory]
+ *         (defaults to ./data)
+ *
+ */
+
+/// svg
+#include <mkSVG.h>
+#include <mkSVGMetrics.h>
+#include "mkSVGColor.h"
+#include "mkSVGNumber.h"
+#include "mkSVGParserT.h"
+#include "parse_common.h"
+#include "tinyxml/tinyxml.h"
+
+// System
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// count every heap allocation made by the process. every form of operator
+// new is replaced, and every form of delete with it, so each allocation is
+// counted once and freed by the allocator that made it. the allocator is
+// kept out of line: GCC would otherwise see free() called on what operator
+// new returned, and warn that they don't match
+#if defined(__GNUC__)
+#define COUNTED_NOINLINE __attribute__((noinline))
+#else
+#define COUNTED_NOINLINE
+#endif
+
+static std::atomic<size_t> g_allocations(0);
+
+COUNTED_NOINLINE static void *counted_alloc(size_t size) noexcept {
+    g_allocations++;
+    return std::malloc(size ? size : 1);
+}
+
+COUNTED_NOINLINE static void counted_free(void *p) noexcept { std::free(p); }
+
+void *operator new(size_t size) {
+    if (void *p = counted_alloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new[](size_t size) {
+    if (void *p = counted_alloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return counted_alloc(size);
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return counted_alloc(size);
+}
+void operator delete(void *p) noexcept { counted_free(p); }
+void operator delete[](void *p) noexcept { counted_free(p); }
+void operator delete(void *p, size_t) noexcept { counted_free(p); }
+void operator delete[](void *p, size_t) noexcept { counted_free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+    counted_free(p);
+}
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+    counted_free(p);
+}
+
+#ifdef __cpp_aligned_new
+COUNTED_NOINLINE static void *counted_alloc(size_t           size,
+                                            std::align_val_t alignment) noexcept {
+    g_allocations++;
+    // aligned_alloc wants a whole number of alignments, and at least one
+    size_t align = size_t(alignment);
+    size_t rounded = size ? (size + align - 1) / align * align : align;
+    return std::aligned_alloc(align, rounded);
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+    if (void *p = counted_alloc(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new[](size_t size, std::align_val_t alignment) {
+    if (void *p = counted_alloc(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new(size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept {
+    return counted_alloc(size, alignment);
+}
+void *operator new[](size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept {
+    return counted_alloc(size, alignment);
+}
+void operator delete(void *p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept {
+    counted_free(p);
+}
+void operator delete[](void *p, size_t, std::align_val_t) noexcept {
+    counted_free(p);
+}
+void operator delete(void *p, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+    counted_free(p);
+}
+void operator delete[](void *p, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+    counted_free(p);
+}
+#endif
+
+namespace {
+
+/// the null handler, final, for SVG_ParserT to call without the vtable
+class FinalNullSVGHandler final : public NullSVGHandler {};
+
+/// handler that is sent whole elements and drops them
+class BatchNullSVGHandler final : public MonkSVG::ISVGBatchHandler {
+  public:
+    void onGroup(const MonkSVG::SVGAttributes &) {}
+    void onGroupEnd() {}
+    void onUse(const MonkSVG::SVGAttributes &) {}
+    void onUseEnd() {}
+    void onPath(const MonkSVG::SVGPath &) {}
+    void draw() {}
+    void dump(void **, size_t *) {}
+    void optimize() {}
+};
+
+/// run fn repeatedly for about a quarter second and report MB/s and heap
+/// allocations per run, and items per second if fn reads that many
+void benchmark(const char *name, size_t bytes,
+               const std::function<void()> &fn, size_t items = 0,
+               const char *unit = "numbers") {
+    typedef std::chrono::steady_clock clock;
+    fn(); // warm up
+
+    size_t            iterations = 0;
+    size_t            allocations = g_allocations;
+    clock::time_point start = clock::now();
+    clock::duration   elapsed;
+    do {
+        fn();
+        iterations++;
+        elapsed = clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(250));
+    allocations = g_allocations - allocations;
+
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    double mb = double(bytes) * iterations / (1024.0 * 1024.0);
+    printf("%-40s %10.2f MB/s %12.1f allocs/run", name, mb / seconds,
+           double(allocations) / iterations);
+    if (items)
+        printf(" %10.2f M %s/s", items * iterations / seconds / 1e6, unit);
+    printf("\n");
+}
+
+void benchmark_tinyxml(const std::string &svg) {
+    benchmark("TiXmlDocument::Parse", svg.size(), [&]() {
+        TiXmlDocument doc;
+        doc.Parse(svg.c_str());
+    });
+
+    // in-situ parsing is destructive, so the copy is part of the cost
+    benchmark("TiXmlDocument::ParseInSitu", svg.size(), [&]() {
+        std::vector<char> buffer(svg.c_str(), svg.c_str() + svg.size() + 1);
+        TiXmlDocument     doc;
+        doc.ParseInSitu(buffer.data());
+    });
+
+    // the reader's own copy, read one element at a time without building
+    // the tree
+    benchmark("TiXmlReader", svg.size(), [&]() {
+        TiXmlReader        reader(svg.c_str(), svg.size());
+        TiXmlReader::Event event;
+        do {
+            event = reader.Next();
+        } while (event == TiXmlReader::ELEMENT_START ||
+                 event == TiXmlReader::ELEMENT_END);
+    });
+}
+
+/// a polygon with the given number of vertices, like the rooms of a
+/// detailed floor plan
+std::string make_polygon(int vertices) {
+    std::string points;
+    char        vertex[64];
+    for (int i = 0; i < vertices; i++) {
+        snprintf(vertex, sizeof(vertex), "%d.%d,%d.%d ", i % 997, i % 10,
+                 (i * 7) % 991, (i * 3) % 10);
+        points += vertex;
+    }
+    return "<svg><polygon points=\"" + points + "\"/></svg>";
+}
+
+/// many small rects with the given number of attributes each, most of
+/// them presentation attributes
+std::string make_attributed_elements(int elements, int attributes) {
+    static const char *all[] = {
+        "x=\"1\"",           "y=\"2\"",
+        "width=\"3\"",       "height=\"4\"",
+        "fill=\"#336699\"",  "stroke=\"#000000\"",
+        "stroke-width=\"2\"",  "opacity=\"0.5\"",
+        "fill-opacity=\"1\"", "fill-rule=\"evenodd\"",
+        "stroke-opacity=\"1\"", "id=\"r\"",
+        "class=\"room\"",     "style=\"fill:#ff0000;stroke:none\"",
+        "transform=\"translate(1,2)\""};
+    std::string element = "<rect";
+    for (int i = 0; i < attributes; i++) {
+        element += std::string(" ") + all[i];
+    }
+    element += "/>";
+
+    std::string svg = "<svg>";
+    for (int i = 0; i < elements; i++) {
+        svg += element;
+    }
+    return svg + "</svg>";
+}
+
+/// TinyXML tokenizer throughput with each scanner kernel the CPU supports
+void benchmark_tokenizer(const std::string &svg) {
+    const std::string long_path = make_long_path(512 * 1024);
+    const char *kernels[] = {"scalar", "sse2", "avx2", "neon"};
+    std::string best = TiXmlBase::ScanKernel();
+    for (const char *kernel : kernels) {
+        if (!TiXmlBase::SetScanKernel(kernel))
+            continue;
+        std::string name = std::string("tokenizer tiger.svg [") + kernel + "]";
+        benchmark(name.c_str(), svg.size(), [&]() {
+            TiXmlDocument doc;
+            doc.Parse(svg.c_str());
+        });
+        name = std::string("tokenizer 512k path d [") + kernel + "]";
+        benchmark(name.c_str(), long_path.size(), [&]() {
+            TiXmlDocument doc;
+            doc.Parse(long_path.c_str());
+        });
+    }
+    TiXmlBase::SetScanKernel(best.c_str());
+}
+
+/// the whole examples/data corpus, as validated UTF-8 (the default) and as
+/// legacy bytes, to show what the per-character encoding handling costs
+void benchmark_corpus(const std::vector<std::string> &corpus) {
+    size_t bytes = 0;
+    for (const std::string &svg : corpus) {
+        bytes += svg.size();
+    }
+
+    printf("examples/data corpus (%zu files, %zu bytes)\n", corpus.size(),
+           bytes);
+    benchmark("TiXmlDocument::Parse [utf-8]", bytes, [&]() {
+        for (const std::string &svg : corpus) {
+            TiXmlDocument doc;
+            doc.Parse(svg.c_str(), 0, TIXML_ENCODING_UTF8);
+        }
+    });
+    benchmark("TiXmlDocument::Parse [legacy]", bytes, [&]() {
+        for (const std::string &svg : corpus) {
+            TiXmlDocument doc;
+            doc.Parse(svg.c_str(), 0, TIXML_ENCODING_LEGACY);
+        }
+    });
+    benchmark("TiXmlBase::IsValidUTF8", bytes, [&]() {
+        for (const std::string &svg : corpus)
+            TiXmlBase::IsValidUTF8(svg.c_str());
+    });
+}
+
+/// the d attributes of every path in svg, one after another
+std::string path_data(const std::string &svg) {
+    std::string d;
+    for (size_t at = svg.find(" d=\""); at != std::string::npos;
+         at = svg.find(" d=\"", at)) {
+        at += 4;
+        size_t end = svg.find('"', at);
+        d += svg.substr(at, end - at) + " ";
+        at = end;
+    }
+    return d;
+}
+
+/// the number lexer against strtof over the path data of tiger.svg. both
+/// loops step over the command letters one at a time
+void benchmark_numbers(const std::string &svg) {
+    const std::string d = path_data(svg);
+    size_t            numbers = 0;
+    volatile float    sink; // keeps the values from being optimized away
+    for (const char *c = d.c_str(); *c;) {
+        char *end;
+        strtof(c, &end);
+        numbers += end != c;
+        c = end != c ? end : c + 1;
+    }
+
+    benchmark("svg_read_number tiger.svg path data", d.size(), [&]() {
+        for (const char *c = d.c_str(); *c;) {
+            float       value;
+            const char *end = MonkSVG::svg_read_number(c, &value);
+            sink = value;
+            c = end != c ? end : c + 1;
+        }
+    }, numbers);
+    benchmark("strtof tiger.svg path data", d.size(), [&]() {
+        for (const char *c = d.c_str(); *c;) {
+            while (isspace(*c) || *c == ',')
+                c++;
+            char *end;
+            sink = strtof(c, &end);
+            c = end != c ? end : c + 1;
+        }
+    }, numbers);
+}
+
+/// the color parser over the fill and stroke colors of tiger.svg, and over
+/// the other forms a color can take
+void benchmark_colors(const std::string &svg) {
+    std::vector<std::string> colors;
+    for (const char *property : {"fill:", "stroke:"}) {
+        for (size_t at = svg.find(property); at != std::string::npos;
+             at = svg.find(property, at)) {
+            at += strlen(property);
+            colors.push_back(svg.substr(at, svg.find_first_of(";\"", at) - at));
+        }
+    }
+    const std::vector<std::string> forms = {
+        "#abc",         "red",        "cornflowerblue", "rgb(255,128,0)",
+        "rgb(50%,0%,100%)", "rgba(0 0 0 / 0.5)", "hsl(120,100%,25%)",
+        "none"};
+
+    volatile uint32_t sink; // keeps the values from being optimized away
+    auto run = [&](const char *name, const std::vector<std::string> &list) {
+        size_t bytes = 0;
+        for (const std::string &color : list) {
+            bytes += color.size();
+        }
+        benchmark(name, bytes, [&]() {
+            for (const std::string &color : list) {
+                uint32_t rgba = 0;
+                MonkSVG::svg_read_color(color.c_str(), color.size(), &rgba);
+                sink = rgba;
+            }
+        }, list.size(), "colors");
+    };
+    run("svg_read_color tiger.svg colors", colors);
+    run("svg_read_color other forms", forms);
+}
+
+void benchmark_svg_parser(const std::string &svg) {
+    MonkSVG::ISVGHandler::SmartPtr handler =
+        std::make_shared<NullSVGHandler>();
+    benchmark("SVG_Parser::parse (null handler)", svg.size(), [&]() {
+        MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+        parser->parse(svg);
+        MonkSVG::SVG_Parser::destroy(parser);
+    });
+
+    // the same, building nodes for the metadata and editor state too
+    benchmark("SVG_Parser::parse (no skip list)", svg.size(), [&]() {
+        MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+        parser->setSkipList(std::vector<std::string>());
+        parser->parse(svg);
+        MonkSVG::SVG_Parser::destroy(parser);
+    });
+
+    // path data alone: one long path, nearly all of it numbers and commands
+    const std::string long_path = make_long_path(512 * 1024);
+    benchmark("SVG_Parser::parse 512k path d", long_path.size(), [&]() {
+        MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+        parser->parse(long_path);
+        MonkSVG::SVG_Parser::destroy(parser);
+    });
+
+    // a small icon, where the per-document setup is most of the cost
+    const std::string icon =
+        "<svg width=\"24px\" height=\"24px\" viewBox=\"0 0 48 48\">"
+        "<path d=\"M4 4h40v40H4z\" fill=\"#336699\"/></svg>";
+    benchmark("SVG_Parser::parse small icon", icon.size(), [&]() {
+        MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+        parser->parse(icon);
+        MonkSVG::SVG_Parser::destroy(parser);
+    });
+
+    // what each element's attributes cost
+    for (int attributes : {0, 5, 15}) {
+        const int         elements = 10000;
+        const std::string svg = make_attributed_elements(elements, attributes);
+        std::string       name = "SVG_Parser::parse " +
+                           std::to_string(attributes) + " attributes";
+        benchmark(name.c_str(), svg.size(), [&]() {
+            MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+            parser->parse(svg);
+            MonkSVG::SVG_Parser::destroy(parser);
+        }, elements, "elements");
+    }
+
+    const int         uses = 10000;
+    const std::string icons = make_icon_sheet(100, uses);
+    benchmark("SVG_Parser::parse icon sheet", icons.size(), [&]() {
+        MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+        parser->parse(icons);
+        MonkSVG::SVG_Parser::destroy(parser);
+    }, uses, "uses");
+
+    const std::string polygon = make_polygon(100000);
+    benchmark("SVG_Parser::parse 100k point polygon", polygon.size(), [&]() {
+        MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+        parser->parse(polygon);
+        MonkSVG::SVG_Parser::destroy(parser);
+    });
+}
+
+/// the same parse through create(), which calls the handler through the
+/// vtable, and through SVG_ParserT with a final handler, which doesn't;
+/// then with a handler sent whole elements, one virtual call for each
+void benchmark_dispatch(const std::string &tiger) {
+    auto virtual_handler = std::make_shared<NullSVGHandler>();
+    auto static_handler = std::make_shared<FinalNullSVGHandler>();
+    auto batch_handler = std::make_shared<BatchNullSVGHandler>();
+    const std::string long_path = make_long_path(512 * 1024);
+    const std::string polygon = make_polygon(100000);
+    const struct {
+        const char        *name;
+        const std::string &svg;
+    } inputs[] = {{"tiger", tiger},
+                  {"512k path d", long_path},
+                  {"100k point polygon", polygon}};
+    for (const auto &input : inputs) {
+        std::string name = std::string("SVG_Parser::parse ") + input.name;
+        benchmark((name + " [virtual]").c_str(), input.svg.size(), [&]() {
+            MonkSVG::SVG_Parser *parser =
+                MonkSVG::SVG_Parser::create(virtual_handler);
+            parser->parse(input.svg);
+            MonkSVG::SVG_Parser::destroy(parser);
+        });
+        benchmark((name + " [static]").c_str(), input.svg.size(), [&]() {
+            MonkSVG::SVG_ParserT<FinalNullSVGHandler> parser(static_handler);
+            parser.parse(input.svg);
+        });
+        benchmark((name + " [batch]").c_str(), input.svg.size(), [&]() {
+            MonkSVG::SVG_Parser *parser =
+                MonkSVG::SVG_Parser::create(batch_handler);
+            parser->parse(input.svg);
+            MonkSVG::SVG_Parser::destroy(parser);
+        });
+    }
+}
+
+/// what each normalization costs, on top of the parse
+void benchmark_normalization(const std::string &tiger) {
+    auto              handler = std::make_shared<BatchNullSVGHandler>();
+    const std::string long_path = make_long_path(512 * 1024);
+    const struct {
+        const char *name;
+        int         normalization;
+    } modes[] = {{"none", MonkSVG::SVG_Parser::NORMALIZE_NONE},
+                 {"absolute", MonkSVG::SVG_Parser::NORMALIZE_ABSOLUTE},
+                 {"arcs", MonkSVG::SVG_Parser::NORMALIZE_ARCS}};
+    for (const std::string *svg : {&tiger, &long_path}) {
+        for (const auto &mode : modes) {
+            std::string name = std::string("SVG_Parser::parse ") +
+                               (svg == &tiger ? "tiger" : "512k path d") +
+                               " [" + mode.name + "]";
+            benchmark(name.c_str(), svg->size(), [&]() {
+                MonkSVG::SVG_Parser *parser =
+                    MonkSVG::SVG_Parser::create(handler);
+                parser->setPathNormalization(mode.normalization);
+                parser->parse(*svg);
+                MonkSVG::SVG_Parser::destroy(parser);
+            });
+        }
+    }
+}
+
+/// a full parse, every style decoded and every call made, against
+/// svg_measure on the same documents
+void benchmark_metrics(const std::vector<std::string> &corpus,
+                       const std::string              &tiger) {
+    size_t bytes = 0;
+    for (const std::string &svg : corpus) {
+        bytes += svg.size();
+    }
+    const std::string icons = make_icon_sheet(20, 2000);
+    const struct {
+        const char                     *name;
+        size_t                          bytes;
+        std::vector<const std::string *> documents;
+    } inputs[] = {
+        {"tiger", tiger.size(), {&tiger}},
+        {"corpus", bytes, {}},
+        {"icon sheet", icons.size(), {&icons}},
+    };
+    for (const auto &input : inputs) {
+        std::vector<const std::string *> documents = input.documents;
+        if (documents.empty()) {
+            for (const std::string &svg : corpus) {
+                documents.push_back(&svg);
+            }
+        }
+        auto handler = std::make_shared<ChecksumSVGHandler>();
+        benchmark(
+            (std::string("full parse ") + input.name).c_str(), input.bytes,
+            [&]() {
+                for (const std::string *svg : documents) {
+                    MonkSVG::SVG_Parser *parser =
+                        MonkSVG::SVG_Parser::create(handler);
+                    parser->parse(*svg);
+                    MonkSVG::SVG_Parser::destroy(parser);
+                }
+            });
+        benchmark((std::string("svg_measure ") + input.name).c_str(),
+                  input.bytes, [&]() {
+                      for (const std::string *svg : documents) {
+                          MonkSVG::SVGMetrics metrics;
+                          MonkSVG::svg_measure(*svg, &metrics);
+                      }
+                  });
+    }
+}
+
+/// what looking at the limits costs: the corpus with every limit set, so
+/// none are reached, and with none
+void benchmark_limits(const std::vector<std::string> &corpus) {
+    size_t bytes = 0;
+    for (const std::string &svg : corpus) {
+        bytes += svg.size();
+    }
+    auto              handler = std::make_shared<NullSVGHandler>();
+    std::atomic<bool> cancel(false);
+    for (bool limited : {false, true}) {
+        benchmark(limited ? "SVG_Parser::parse corpus [limits]"
+                          : "SVG_Parser::parse corpus [no limits]",
+                  bytes, [&]() {
+                      for (const std::string &svg : corpus) {
+                          MonkSVG::SVG_Parser *parser =
+                              MonkSVG::SVG_Parser::create(handler);
+                          if (limited) {
+                              parser->setDeadline(
+                                  std::chrono::steady_clock::now() +
+                                  std::chrono::seconds(60));
+                              parser->setCancelFlag(&cancel);
+                              parser->setMaxElements(1 << 24);
+                              parser->setMaxSegments(1 << 24);
+                              parser->setMaxBytes(1 << 30);
+                          }
+                          parser->parse(svg);
+                          MonkSVG::SVG_Parser::destroy(parser);
+                      }
+                  });
+    }
+}
+
+/// how often each file repeats its style and transform strings, and what
+/// the caches save on the whole corpus
+void benchmark_caches(const std::vector<std::string> &corpus) {
+    MonkSVG::ISVGHandler::SmartPtr handler =
+        std::make_shared<NullSVGHandler>();
+    size_t bytes = 0;
+    for (size_t i = 0; i < corpus.size(); i++) {
+        MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+        parser->parse(corpus[i]);
+        MonkSVG::SVG_Parser::CacheStats style = parser->styleCacheStats();
+        MonkSVG::SVG_Parser::CacheStats transform =
+            parser->transformCacheStats();
+        MonkSVG::SVG_Parser::destroy(parser);
+        printf("%-40s style %6zu hits %6zu misses   transform %6zu hits "
+               "%6zu misses\n",
+               corpus_files[i], style.hits, style.misses, transform.hits,
+               transform.misses);
+        bytes += corpus[i].size();
+    }
+
+    for (size_t capacity : {size_t(1024), size_t(0)}) {
+        std::string name = capacity ? "SVG_Parser::parse corpus [cached]"
+                                    : "SVG_Parser::parse corpus [uncached]";
+        benchmark(name.c_str(), bytes, [&]() {
+            for (const std::string &svg : corpus) {
+                MonkSVG::SVG_Parser *parser =
+                    MonkSVG::SVG_Parser::create(handler);
+                parser->setCacheCapacity(capacity);
+                parser->parse(svg);
+                MonkSVG::SVG_Parser::destroy(parser);
+            }
+        });
+    }
+
+    // one style and one transform, on every element
+    const int         elements = 10000;
+    const std::string svg = make_attributed_elements(elements, 15);
+    for (size_t capacity : {size_t(1024), size_t(0)}) {
+        std::string name = capacity ? "SVG_Parser::parse 15 attributes [cached]"
+                                    : "SVG_Parser::parse 15 attributes [uncached]";
+        benchmark(name.c_str(), svg.size(), [&]() {
+            MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+            parser->setCacheCapacity(capacity);
+            parser->parse(svg);
+            MonkSVG::SVG_Parser::destroy(parser);
+        }, elements, "elements");
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string data_dir = argc > 1 ? argv[1] : "./data";
+    std::string tiger = load_file(data_dir + "/tiger.svg");
+    if (tiger.empty()) {
+        std::cerr << "ERROR: could not load " << data_dir << "/tiger.svg"
+                  << std::endl;
+        return -1;
+    }
+
+    printf("tiger.svg (%zu bytes)\n", tiger.size());
+    benchmark_tinyxml(tiger);
+    benchmark_tokenizer(tiger);
+    benchmark_numbers(tiger);
+    benchmark_colors(tiger);
+    benchmark_svg_parser(tiger);
+    benchmark_dispatch(tiger);
+    benchmark_normalization(tiger);
+
+    std::vector<std::string> corpus = load_corpus(data_dir);
+    benchmark_corpus(corpus);
+    benchmark_caches(corpus);
+    benchmark_metrics(corpus, tiger);
+    benchmark_limits(corpus);
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ *  parse_common.h
+ *  MonkSVG
+ *
+ *  Handlers, documents and the examples/data corpus shared by the parser
+ *  benchmarks and tests.
+ *
+ */
+
+#ifndef __parse_common_h__
+#define __parse_common_h__
+
+/// svg
+#include <mkSVG.h>
+
+// System
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// handler that drops every callback, so only the parser is measured
+class NullSVGHandler : public MonkSVG::ISVGHandler {
+  public:
+    void onTransformTranslate(float, float) {}
+    void onTransformScale(float) {}
+    void onTransformRotate(float) {}
+    void onTransformMatrix(float, float, float, float, float, float) {}
+    void onGroupBegin() {}
+    void onGroupEnd() {}
+    void onUseBegin() {}
+    void onUseEnd() {}
+    void onId(const std::string &) {}
+    void onPathBegin() {}
+    void onPathEnd() {}
+    void onPathMoveTo(float, float) {}
+    void onPathClose() {}
+    void onPathLineTo(float, float) {}
+    void onPathCubic(float, float, float, float, float, float) {}
+    void onPathSCubic(float, float, float, float) {}
+    void onPathArc(float, float, float, int, int, float, float) {}
+    void onPathRect(float, float, float, float) {}
+    void onPathHorizontalLine(float) {}
+    void onPathVerticalLine(float) {}
+    void onPathQuad(float, float, float, float) {}
+    // onPathSQuad is left to ISVGHandler, as in a handler written before it
+    void onPathFillColor(unsigned int) {}
+    void onPathFillOpacity(float) {}
+    void onPathFillRule(const std::string &) {}
+    void onPathStrokeColor(unsigned int) {}
+    void onPathStrokeOpacity(float) {}
+    void onPathStrokeWidth(float) {}
+    void draw() {}
+    void dump(void **, size_t *) {}
+    void optimize() {}
+};
+
+/// handler that sums what it is sent, so separate parses can be compared
+class ChecksumSVGHandler : public NullSVGHandler {
+  public:
+    double sum = 0;
+    void   onPathBegin() { sum += 1; }
+    void   onPathMoveTo(float x, float y) { sum += x + 2 * y; }
+    void   onPathLineTo(float x, float y) { sum += 3 * x + 4 * y; }
+    void   onPathCubic(float x1, float y1, float x2, float y2, float x3,
+                       float y3) {
+        sum += x1 + y1 + x2 + y2 + 5 * x3 + 6 * y3;
+    }
+    void onPathFillColor(unsigned int color) { sum += color; }
+    void onTransformMatrix(float a, float b, float c, float d, float e,
+                           float f) {
+        sum += a + b + c + d + e + f;
+    }
+};
+
+inline std::string load_file(const std::string &path) {
+    std::fstream      is(path.c_str(), std::fstream::in);
+    std::stringstream ss;
+    ss << is.rdbuf();
+    return ss.str();
+}
+
+/// a single path with a d attribute of about the given size, the shape of
+/// the long map outlines that dominate tokenizer time
+inline std::string make_long_path(size_t bytes) {
+    std::string d;
+    char        segment[64];
+    for (int i = 0; d.size() < bytes; i++) {
+        snprintf(segment, sizeof(segment), "L%d.%d,%d.%d ", i % 997, i % 10,
+                 (i * 7) % 991, (i * 3) % 10);
+        d += segment;
+    }
+    return "<svg><path d=\"" + d + "\"/></svg>";
+}
+
+/// an icon sheet: symbols of a few paths each, then many uses of them
+inline std::string make_icon_sheet(int symbols, int uses) {
+    std::string svg = "<svg width=\"512\" height=\"512\">";
+    for (int i = 0; i < symbols; i++) {
+        svg += "<symbol id=\"icon" + std::to_string(i) + "\">";
+        for (int j = 0; j < 4; j++) {
+            svg += "<path style=\"fill:#336699;stroke:none\" "
+                   "d=\"M2 2h20v20H2z M6 6c3 0 6 3 6 6s-3 6-6 6\"/>";
+        }
+        svg += "</symbol>";
+    }
+    for (int i = 0; i < uses; i++) {
+        svg += "<use xlink:href=\"#icon" + std::to_string(i % symbols) +
+               "\" transform=\"translate(" + std::to_string(i % 20 * 24) +
+               "," + std::to_string(i / 20 % 20 * 24) + ")\"/>";
+    }
+    return svg + "</svg>";
+}
+
+static const char *const corpus_files[] = {
+    "circle.svg",   "circle_poly.svg",     "fish02.svg", "fish03.svg",
+    "fish_top.svg", "linear_gradient.svg", "square.svg", "tiger.svg"};
+
+inline std::vector<std::string> load_corpus(const std::string &data_dir) {
+    std::vector<std::string> corpus;
+    for (const char *file : corpus_files) {
+        corpus.push_back(load_file(data_dir + "/" + file));
+    }
+    return corpus;
+}
+
+#endif // __parse_common_h__
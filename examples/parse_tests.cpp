@@ -0,0 +1,1243 @@
+/*
+ *  parse_tests.cpp
+ *  MonkSVG
+ *
+ *  Checks that the parser reads what it should: colors, numbers, paths,
+ *  metrics, limits, each element once, the same through every handler
+ *  interface, and the same on several threads at once. Needs no window or
+ *  rendering backend.
+ *
+ *  usage: parse_tests [data directory] [threads]
+ *         (defaults to ./data and one thread per core)
+ *
+ */
+
+/// svg
+#include <mkSVG.h>
+#include <mkSVGMetrics.h>
+#include "mkSVGColor.h"
+#include "mkSVGNumber.h"
+#include "mkSVGParserT.h"
+#include "parse_common.h"
+#include "tinyxml/tinyxml.h"
+
+// System
+#include <atomic>
+#include <chrono>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// the checksum handler, final, for SVG_ParserT to call without the vtable
+class FinalChecksumSVGHandler final : public ChecksumSVGHandler {};
+
+/// ChecksumSVGHandler's sum, from whole elements
+class BatchChecksumSVGHandler final : public MonkSVG::ISVGBatchHandler {
+  public:
+    double sum = 0;
+    void   onGroup(const MonkSVG::SVGAttributes &attributes) {
+        add(attributes);
+    }
+    void onGroupEnd() {}
+    void onUse(const MonkSVG::SVGAttributes &attributes) { add(attributes); }
+    void onUseEnd() {}
+    void onPath(const MonkSVG::SVGPath &path) {
+        sum += 1;
+        const float *c = path.coordinates;
+        for (size_t i = 0; i < path.command_count; i++) {
+            switch (path.commands[i] & MonkSVG::SVG_PATH_COMMAND_MASK) {
+            case MonkSVG::SVG_PATH_MOVE_TO:
+                sum += c[0] + 2 * c[1];
+                break;
+            case MonkSVG::SVG_PATH_LINE_TO:
+                sum += 3 * c[0] + 4 * c[1];
+                break;
+            case MonkSVG::SVG_PATH_CUBIC:
+                sum += c[0] + c[1] + c[2] + c[3] + 5 * c[4] + 6 * c[5];
+                break;
+            }
+            c += MonkSVG::svg_path_coordinates(path.commands[i]);
+        }
+        add(path.attributes);
+    }
+    void draw() {}
+    void dump(void **, size_t *) {}
+    void optimize() {}
+
+  private:
+    void add(const MonkSVG::SVGAttributes &a) {
+        if (a.set & MonkSVG::SVGAttributes::FILL) {
+            sum += a.fill_color;
+        }
+        if (a.set & MonkSVG::SVGAttributes::TRANSFORM) {
+            const MonkSVG::Transform2d &m = a.transform;
+            sum += m.a + m.b + m.c + m.d + m.e + m.f;
+        }
+    }
+};
+
+/// handler that counts the elements it is sent
+class CountingSVGHandler : public NullSVGHandler {
+  public:
+    size_t groups = 0, paths = 0, uses = 0;
+    void   onGroupBegin() { groups++; }
+    void   onPathBegin() { paths++; }
+    void   onUseBegin() { uses++; }
+};
+
+/// the same, and whether every group and use it is sent is ended
+class BalanceSVGHandler : public CountingSVGHandler {
+  public:
+    long open = 0;
+    bool underflow = false;
+    void onGroupBegin() {
+        CountingSVGHandler::onGroupBegin();
+        open++;
+    }
+    void onUseBegin() {
+        CountingSVGHandler::onUseBegin();
+        open++;
+    }
+    void onGroupEnd() { underflow |= --open < 0; }
+    void onUseEnd() { underflow |= --open < 0; }
+};
+
+/// the color parser against a table of colors and what they should read as.
+/// returns the number of mismatches
+size_t check_colors() {
+    using namespace MonkSVG;
+    static const struct {
+        const char  *color;
+        SVGColorKind kind;
+        uint32_t     rgba;
+    } cases[] = {
+        {"#336699", SVG_COLOR_RGBA, 0x336699ff},
+        {"#FFcc00", SVG_COLOR_RGBA, 0xffcc00ff},
+        {"#abc", SVG_COLOR_RGBA, 0xaabbccff},
+        {"#abcd", SVG_COLOR_RGBA, 0xaabbccdd},
+        {"#11223344", SVG_COLOR_RGBA, 0x11223344},
+        {"  #000000 ", SVG_COLOR_RGBA, 0x000000ff},
+        {"#12345", SVG_COLOR_INVALID, 0},
+        {"#ggg", SVG_COLOR_INVALID, 0},
+        {"#", SVG_COLOR_INVALID, 0},
+        {"red", SVG_COLOR_RGBA, 0xff0000ff},
+        {"Red", SVG_COLOR_RGBA, 0xff0000ff},
+        {"green", SVG_COLOR_RGBA, 0x008000ff},
+        {"grey", SVG_COLOR_RGBA, 0x808080ff},
+        {"aliceblue", SVG_COLOR_RGBA, 0xf0f8ffff},
+        {"lightgoldenrodyellow", SVG_COLOR_RGBA, 0xfafad2ff},
+        {"rebeccapurple", SVG_COLOR_RGBA, 0x663399ff},
+        {"yellowgreen", SVG_COLOR_RGBA, 0x9acd32ff},
+        {"transparent", SVG_COLOR_RGBA, 0x00000000},
+        {"reds", SVG_COLOR_INVALID, 0},
+        {"dark blue", SVG_COLOR_INVALID, 0},
+        {"", SVG_COLOR_INVALID, 0},
+        {"none", SVG_COLOR_NONE, 0},
+        {"None", SVG_COLOR_NONE, 0},
+        {"currentColor", SVG_COLOR_CURRENT, 0},
+        {"url(#gradient)", SVG_COLOR_INVALID, 0},
+        {"rgb(255,128,0)", SVG_COLOR_RGBA, 0xff8000ff},
+        {"rgb( 255 , 128 , 0 )", SVG_COLOR_RGBA, 0xff8000ff},
+        {"RGB(255 128 0)", SVG_COLOR_RGBA, 0xff8000ff},
+        {"rgb(50%,0%,100%)", SVG_COLOR_RGBA, 0x8000ffff},
+        {"rgb(300,-5,0)", SVG_COLOR_RGBA, 0xff0000ff},
+        {"rgba(255,0,0,0.5)", SVG_COLOR_RGBA, 0xff000080},
+        {"rgb(255 0 0 / 50%)", SVG_COLOR_RGBA, 0xff000080},
+        {"rgb(255,0)", SVG_COLOR_INVALID, 0},
+        {"rgb(255,0,0,1,1)", SVG_COLOR_INVALID, 0},
+        {"rgb(255,0,0", SVG_COLOR_INVALID, 0},
+        {"rgb(255,0,0) x", SVG_COLOR_INVALID, 0},
+        {"rgb(1,2,3,)", SVG_COLOR_INVALID, 0},
+        {"rgb(1,2,3 , )", SVG_COLOR_INVALID, 0},
+        {"rgba(1,2,3,0.5,)", SVG_COLOR_INVALID, 0},
+        {"rgb(,1,2,3)", SVG_COLOR_INVALID, 0},
+        {"rgb(1,,2,3)", SVG_COLOR_INVALID, 0},
+        {"rgb(1 2 3 /)", SVG_COLOR_INVALID, 0},
+        {"rgb(255, 0, 0 / 0.5)", SVG_COLOR_RGBA, 0xff000080},
+        {"hsl(0,100%,50%)", SVG_COLOR_RGBA, 0xff0000ff},
+        {"hsl(120deg,100%,50%)", SVG_COLOR_RGBA, 0x00ff00ff},
+        {"hsl(240,100%,25%)", SVG_COLOR_RGBA, 0x000080ff},
+        {"hsl(-120,100%,50%)", SVG_COLOR_RGBA, 0x0000ffff},
+        {"hsl(0,0%,100%)", SVG_COLOR_RGBA, 0xffffffff},
+        {"hsla(60,100%,50%,0)", SVG_COLOR_RGBA, 0xffff0000},
+        {"hsv(0,0%,0%)", SVG_COLOR_INVALID, 0},
+    };
+
+    size_t mismatches = 0;
+    for (const auto &c : cases) {
+        uint32_t     rgba = 0;
+        SVGColorKind kind = svg_read_color(c.color, strlen(c.color), &rgba);
+        if (kind != c.kind || rgba != c.rgba) {
+            if (mismatches++ < 10)
+                std::cerr << "mismatch: \"" << c.color << "\"" << std::endl;
+        }
+    }
+    printf("%-40s %10zu colors %10zu mismatches\n", "svg_read_color",
+           sizeof(cases) / sizeof(cases[0]), mismatches);
+    return mismatches;
+}
+
+/// handler that keeps the last fill opacity and stroke width it is sent
+class StyleSVGHandler : public NullSVGHandler {
+  public:
+    float fill_opacity = -1, stroke_width = -1;
+    void  onPathFillOpacity(float o) { fill_opacity = o; }
+    void  onPathStrokeWidth(float w) { stroke_width = w; }
+};
+
+/// fill-opacity and opacity, from attributes and style, combine into the
+/// one fill opacity the handler is sent. returns the number of mismatches
+size_t check_opacity() {
+    static const struct {
+        const char *element;
+        float       fill_opacity;
+    } cases[] = {
+        {"<rect fill-opacity='0.3'/>", 0.3f},
+        {"<rect opacity='0.3'/>", 0.3f},
+        {"<rect opacity='0.5' fill-opacity='0.4'/>", 0.2f},
+        {"<rect fill-opacity='0.4' opacity='0.5'/>", 0.2f},
+        {"<rect style='opacity:0.5;fill-opacity:0.4'/>", 0.2f},
+        {"<rect style='fill-opacity:0.4;opacity:0.5'/>", 0.2f},
+        {"<rect opacity='0.5' style='fill-opacity:0.4'/>", 0.2f},
+        {"<rect fill-opacity='0.9' style='fill-opacity:0.4'/>", 0.4f},
+        {"<rect/>", -1},
+    };
+
+    size_t mismatches = 0;
+    for (const auto &c : cases) {
+        auto handler = std::make_shared<StyleSVGHandler>();
+        MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+        parser->parse(std::string("<svg>") + c.element + "</svg>");
+        MonkSVG::SVG_Parser::destroy(parser);
+        if (std::fabs(handler->fill_opacity - c.fill_opacity) > 1e-6f) {
+            if (mismatches++ < 10)
+                std::cerr << "mismatch: " << c.element << " gives "
+                          << handler->fill_opacity << std::endl;
+        }
+    }
+    printf("%-40s %10zu paths %11zu mismatches\n", "fill opacity",
+           sizeof(cases) / sizeof(cases[0]), mismatches);
+    return mismatches;
+}
+
+/// a number property is one whole number, read from all of its value
+/// however long, or it isn't set. returns the number of mismatches
+size_t check_style_numbers() {
+    // 0.1, written out past the length of any scratch copy
+    const std::string tenth = "0." + std::string(62, '0') + "1e62";
+    const struct {
+        std::string element;
+        float       fill_opacity, stroke_width;
+    } cases[] = {
+        {"<rect fill-opacity=' 0.25 ' stroke-width='2'/>", 0.25f, 2},
+        {"<rect style='fill-opacity:" + tenth + "'/>", 0.1f, -1},
+        {"<rect fill-opacity='" + tenth + "'/>", 0.1f, -1},
+        {"<rect fill-opacity='0.4' style='fill-opacity:0.5x'/>", 0.4f, -1},
+        {"<rect fill-opacity='0.4' style='fill-opacity:,0.5'/>", 0.4f, -1},
+        {"<rect fill-opacity='0.4' style='fill-opacity:0.5 0.6'/>", 0.4f, -1},
+        {"<rect fill-opacity='inherit'/>", -1, -1},
+        {"<rect style='stroke-width: 3px ; fill-opacity:.5'/>", 0.5f, 3},
+        {"<rect stroke-width='2' style='stroke-width:3em'/>", -1, 2},
+    };
+
+    size_t mismatches = 0;
+    for (const auto &c : cases) {
+        auto handler = std::make_shared<StyleSVGHandler>();
+        MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+        parser->parse("<svg>" + c.element + "</svg>");
+        MonkSVG::SVG_Parser::destroy(parser);
+        if (std::fabs(handler->fill_opacity - c.fill_opacity) > 1e-6f ||
+            std::fabs(handler->stroke_width - c.stroke_width) > 1e-6f) {
+            if (mismatches++ < 10)
+                std::cerr << "mismatch: " << c.element << " gives "
+                          << handler->fill_opacity << ", "
+                          << handler->stroke_width << std::endl;
+        }
+    }
+    printf("%-40s %10zu paths %11zu mismatches\n", "style numbers",
+           sizeof(cases) / sizeof(cases[0]), mismatches);
+    return mismatches;
+}
+
+/// handler that writes the paths it is sent out as text, one letter per
+/// segment and the coordinates to three places
+class PathTextSVGHandler final : public MonkSVG::ISVGBatchHandler {
+  public:
+    std::string text;
+    void        onGroup(const MonkSVG::SVGAttributes &) {}
+    void        onGroupEnd() {}
+    void        onUse(const MonkSVG::SVGAttributes &) {}
+    void        onUseEnd() {}
+    void        onPath(const MonkSVG::SVGPath &path) {
+        static const char letters[] = "ZMLHVCSQTAR";
+        const float      *c = path.coordinates;
+        for (size_t i = 0; i < path.command_count; i++) {
+            unsigned char command = path.commands[i];
+            if (!text.empty())
+                text += ' ';
+            char letter = letters[command & MonkSVG::SVG_PATH_COMMAND_MASK];
+            text += command & MonkSVG::SVG_PATH_RELATIVE ? char(letter + 32)
+                                                         : letter;
+            if (command & MonkSVG::SVG_PATH_ARC_LARGE)
+                text += '+';
+            if (command & MonkSVG::SVG_PATH_ARC_SWEEP)
+                text += '*';
+            for (int j = 0; j < MonkSVG::svg_path_coordinates(command); j++) {
+                double value = std::round(c[j] * 1000.0) / 1000.0;
+                char   number[32];
+                snprintf(number, sizeof(number), " %g", value == 0 ? 0 : value);
+                text += number;
+            }
+            c += MonkSVG::svg_path_coordinates(command);
+        }
+    }
+    void draw() {}
+    void dump(void **, size_t *) {}
+    void optimize() {}
+};
+
+/// the segments each normalization gives for small paths. returns the
+/// number of mismatches
+size_t check_normalize() {
+    using MonkSVG::SVG_Parser;
+    static const struct {
+        const char *element;
+        int         normalization;
+        const char *segments;
+    } cases[] = {
+        {"<path d='m10 10 h5 v5 z l1 1'/>", SVG_Parser::NORMALIZE_NONE,
+         "m 10 10 h 5 v 5 z l 1 1"},
+        {"<path d='m10 10 h5 v5 z l1 1'/>", SVG_Parser::NORMALIZE_ABSOLUTE,
+         "M 10 10 L 15 10 L 15 15 Z L 11 11"},
+        {"<path d='M0 0 C1 2 3 4 5 6 s1 1 2 2'/>",
+         SVG_Parser::NORMALIZE_ABSOLUTE, "M 0 0 C 1 2 3 4 5 6 C 7 8 6 7 7 8"},
+        {"<path d='M0 0 L5 5 S1 1 2 2'/>", SVG_Parser::NORMALIZE_ABSOLUTE,
+         "M 0 0 L 5 5 C 5 5 1 1 2 2"},
+        {"<path d='M0 0 Q1 1 2 0 T4 0 t2 0'/>", SVG_Parser::NORMALIZE_ABSOLUTE,
+         "M 0 0 Q 1 1 2 0 Q 3 -1 4 0 Q 5 1 6 0"},
+        {"<path d='M0 0 Q1 1 2 0 L3 3 T4 4'/>", SVG_Parser::NORMALIZE_ABSOLUTE,
+         "M 0 0 Q 1 1 2 0 L 3 3 Q 3 3 4 4"},
+        {"<path d='m5 5 l5 0 0 5 z m1 1 l1 0'/>",
+         SVG_Parser::NORMALIZE_ABSOLUTE,
+         "M 5 5 L 10 5 L 10 10 Z M 6 6 L 7 6"},
+        {"<path d='m5 5 a1 2 30 1 0 3 4'/>", SVG_Parser::NORMALIZE_ABSOLUTE,
+         "M 5 5 A+ 1 2 30 8 9"},
+        {"<path d='M0 0 A10 10 0 0 1 10 10'/>", SVG_Parser::NORMALIZE_ARCS,
+         "M 0 0 C 5.523 0 10 4.477 10 10"},
+        {"<path d='M0 0 A5 5 0 1 1 10 0'/>", SVG_Parser::NORMALIZE_ARCS,
+         "M 0 0 C 0 -2.761 2.239 -5 5 -5 C 7.761 -5 10 -2.761 10 0"},
+        {"<path d='M0 0 A1 1 0 0 1 10 0'/>", SVG_Parser::NORMALIZE_ARCS,
+         "M 0 0 C 0 -2.761 2.239 -5 5 -5 C 7.761 -5 10 -2.761 10 0"},
+        {"<path d='M0 0 A0 5 0 0 1 3 4 A5 5 0 0 1 3 4'/>",
+         SVG_Parser::NORMALIZE_ARCS, "M 0 0 L 3 4"},
+        {"<rect x='1' y='2' width='3' height='4'/>",
+         SVG_Parser::NORMALIZE_NONE, "R 1 2 3 4"},
+        {"<rect x='1' y='2' width='3' height='4'/>",
+         SVG_Parser::NORMALIZE_ABSOLUTE, "M 1 2 L 4 2 L 4 6 L 1 6 Z"},
+        {"<rect x='1' y='2' width='0' height='4'/>",
+         SVG_Parser::NORMALIZE_ABSOLUTE, ""},
+        {"<polygon points='1 2 3 4 5 6'/>", SVG_Parser::NORMALIZE_ARCS,
+         "M 1 2 L 3 4 L 5 6 Z"},
+        {"<polygon points='1 2 3'/>", SVG_Parser::NORMALIZE_NONE, "M 1 2 Z"},
+        {"<polygon points='1'/>", SVG_Parser::NORMALIZE_NONE, ""},
+        {"<polygon points=''/>", SVG_Parser::NORMALIZE_ABSOLUTE, ""},
+    };
+
+    size_t mismatches = 0;
+    for (const auto &c : cases) {
+        auto         handler = std::make_shared<PathTextSVGHandler>();
+        SVG_Parser *parser = SVG_Parser::create(handler);
+        parser->setPathNormalization(c.normalization);
+        parser->parse(std::string("<svg>") + c.element + "</svg>");
+        SVG_Parser::destroy(parser);
+        if (handler->text != c.segments) {
+            if (mismatches++ < 10)
+                std::cerr << "mismatch: " << c.element << " gives \""
+                          << handler->text << "\"" << std::endl;
+        }
+    }
+    printf("%-40s %10zu paths %11zu mismatches\n", "svg_normalize_path",
+           sizeof(cases) / sizeof(cases[0]), mismatches);
+    return mismatches;
+}
+
+/// handler that finds the bounds of what it is sent by walking along every
+/// segment in small steps. it wants arcs as cubics
+class SampledBoundsSVGHandler final : public MonkSVG::ISVGBatchHandler {
+  public:
+    float bounds[4] = {MAXFLOAT, MAXFLOAT, -MAXFLOAT, -MAXFLOAT};
+
+    void onGroup(const MonkSVG::SVGAttributes &attributes) {
+        push(attributes);
+    }
+    void onGroupEnd() { transforms.pop_back(); }
+    void onUse(const MonkSVG::SVGAttributes &attributes) { push(attributes); }
+    void onUseEnd() { transforms.pop_back(); }
+    void onPath(const MonkSVG::SVGPath &path) {
+        push(path.attributes);
+        const MonkSVG::Transform2d &m = transforms.back();
+        auto add = [&](double x, double y) {
+            float mx = float(m.a * x + m.c * y + m.e);
+            float my = float(m.b * x + m.d * y + m.f);
+            bounds[0] = std::min(bounds[0], mx);
+            bounds[1] = std::min(bounds[1], my);
+            bounds[2] = std::max(bounds[2], mx);
+            bounds[3] = std::max(bounds[3], my);
+        };
+        const int    steps = 256;
+        float        x = 0, y = 0, start_x = 0, start_y = 0;
+        const float *c = path.coordinates;
+        for (size_t i = 0; i < path.command_count; i++) {
+            unsigned char command = path.commands[i];
+            switch (command) {
+            case MonkSVG::SVG_PATH_MOVE_TO:
+                x = start_x = c[0];
+                y = start_y = c[1];
+                break;
+            case MonkSVG::SVG_PATH_CLOSE:
+            case MonkSVG::SVG_PATH_LINE_TO: {
+                float end[2] = {start_x, start_y};
+                if (command == MonkSVG::SVG_PATH_LINE_TO) {
+                    end[0] = c[0];
+                    end[1] = c[1];
+                }
+                add(x, y);
+                add(end[0], end[1]);
+                x = end[0];
+                y = end[1];
+                break;
+            }
+            case MonkSVG::SVG_PATH_CUBIC:
+                for (int j = 0; j <= steps; j++) {
+                    double t = double(j) / steps, u = 1 - t;
+                    double w[4] = {u * u * u, 3 * u * u * t, 3 * u * t * t,
+                                   t * t * t};
+                    add(w[0] * x + w[1] * c[0] + w[2] * c[2] + w[3] * c[4],
+                        w[0] * y + w[1] * c[1] + w[2] * c[3] + w[3] * c[5]);
+                }
+                x = c[4];
+                y = c[5];
+                break;
+            case MonkSVG::SVG_PATH_QUAD:
+                for (int j = 0; j <= steps; j++) {
+                    double t = double(j) / steps, u = 1 - t;
+                    double w[3] = {u * u, 2 * u * t, t * t};
+                    add(w[0] * x + w[1] * c[0] + w[2] * c[2],
+                        w[0] * y + w[1] * c[1] + w[2] * c[3]);
+                }
+                x = c[2];
+                y = c[3];
+                break;
+            }
+            c += MonkSVG::svg_path_coordinates(command);
+        }
+        transforms.pop_back();
+    }
+    void draw() {}
+    void dump(void **, size_t *) {}
+    void optimize() {}
+
+  private:
+    std::vector<MonkSVG::Transform2d> transforms;
+
+    void push(const MonkSVG::SVGAttributes &attributes) {
+        const MonkSVG::Transform2d &top =
+            transforms.empty() ? viewportTransform() : transforms.back();
+        MonkSVG::Transform2d product = top;
+        if (attributes.set & MonkSVG::SVGAttributes::TRANSFORM) {
+            MonkSVG::Transform2d::multiply(product, top,
+                                           attributes.transform);
+        }
+        transforms.push_back(product);
+    }
+};
+
+/// svg_measure on small documents, against what they should measure, then
+/// on the corpus against bounds found by sampling. returns the number of
+/// mismatches
+size_t check_metrics(const std::vector<std::string> &corpus) {
+    static const struct {
+        const char *svg;
+        float       bounds[4];
+        size_t      paths, segments, groups, uses;
+    } cases[] = {
+        {"<svg><path d='M0 0 L10 20'/></svg>", {0, 0, 10, 20}, 1, 2, 0, 0},
+        {"<svg><path d='M0 0 C0 10 10 10 10 0'/></svg>",
+         {0, 0, 10, 7.5f}, 1, 2, 0, 0},
+        {"<svg><path d='M0 0 Q5 10 10 0'/></svg>", {0, 0, 10, 5}, 1, 2, 0, 0},
+        {"<svg><path d='M0 0 A5 5 0 1 1 10 0'/></svg>",
+         {0, -5, 10, 0}, 1, 2, 0, 0},
+        {"<svg><path d='M0 5 A5 5 0 1 0 10 5 A5 5 0 1 0 0 5'/></svg>",
+         {0, 0, 10, 10}, 1, 3, 0, 0},
+        {"<svg><path transform='scale(2 1)' "
+         "d='M0 5 a5 5 0 1 0 10 0 a5 5 0 1 0 -10 0'/></svg>",
+         {0, 0, 20, 10}, 1, 3, 0, 0},
+        {"<svg><path transform='rotate(45)' "
+         "d='M-10 0 A10 5 0 1 0 10 0 A10 5 0 1 0 -10 0'/></svg>",
+         {-7.906f, -7.906f, 7.906f, 7.906f}, 1, 3, 0, 0},
+        {"<svg><path d='m0 0 h10 M50 50'/></svg>", {0, 0, 10, 0}, 1, 3, 0, 0},
+        {"<svg><path d='M50 50'/></svg>",
+         {MAXFLOAT, MAXFLOAT, -MAXFLOAT, -MAXFLOAT}, 1, 1, 0, 0},
+        {"<svg><g transform='translate(10 10)'><rect x='1' y='2' width='3' "
+         "height='4' transform='scale(2)' style='fill:red'/></g></svg>",
+         {12, 14, 18, 22}, 1, 1, 1, 0},
+        {"<svg width='100' height='100' viewBox='0 0 10 10'>"
+         "<polygon points='1 1 2 1 2 2'/></svg>",
+         {10, 10, 20, 20}, 1, 4, 0, 0},
+        {"<svg><symbol id='s'><path d='M0 0 l1 1'/></symbol>"
+         "<use xlink:href='#s' transform='translate(5 0)'/>"
+         "<g transform='translate(0 5)'><use xlink:href='#s'/></g></svg>",
+         {0, 0, 6, 6}, 2, 4, 1, 2},
+    };
+
+    size_t mismatches = 0;
+    for (const auto &c : cases) {
+        MonkSVG::SVGMetrics metrics;
+        MonkSVG::svg_measure(c.svg, &metrics);
+        const float found[4] = {metrics.min_x, metrics.min_y, metrics.max_x,
+                                metrics.max_y};
+        bool        same = metrics.paths == c.paths &&
+                    metrics.segments == c.segments &&
+                    metrics.groups == c.groups && metrics.uses == c.uses;
+        for (int i = 0; i < 4; i++) {
+            same = same && std::fabs(found[i] - c.bounds[i]) <= 1e-3f;
+        }
+        if (!same) {
+            if (mismatches++ < 10)
+                std::cerr << "mismatch: " << c.svg << " measures "
+                          << found[0] << " " << found[1] << " " << found[2]
+                          << " " << found[3] << ", " << metrics.paths << " "
+                          << metrics.segments << " " << metrics.groups << " "
+                          << metrics.uses << std::endl;
+        }
+    }
+
+    // sampling finds a box inside the true one, and a hair short of it
+    std::vector<std::string> documents = corpus;
+    documents.push_back(make_icon_sheet(10, 50));
+    for (size_t i = 0; i < documents.size(); i++) {
+        MonkSVG::SVGMetrics metrics;
+        MonkSVG::svg_measure(documents[i], &metrics);
+        const float found[4] = {metrics.min_x, metrics.min_y, metrics.max_x,
+                                metrics.max_y};
+
+        auto handler = std::make_shared<SampledBoundsSVGHandler>();
+        MonkSVG::SVG_ParserT<SampledBoundsSVGHandler> parser(handler);
+        parser.setPathNormalization(MonkSVG::SVG_Parser::NORMALIZE_ARCS);
+        parser.parse(documents[i]);
+
+        float size = std::max(found[2] - found[0], found[3] - found[1]);
+        float tolerance = 1e-3f * std::max(size, 1.0f);
+        bool  same = true;
+        for (int j = 0; j < 4; j++) {
+            same = same &&
+                   std::fabs(found[j] - handler->bounds[j]) <= tolerance;
+        }
+        if (!same) {
+            if (mismatches++ < 10)
+                std::cerr << "mismatch: "
+                          << (i < corpus.size() ? corpus_files[i]
+                                                : "icon sheet")
+                          << " measures " << found[0] << " " << found[1]
+                          << " " << found[2] << " " << found[3]
+                          << ", sampled " << handler->bounds[0] << " "
+                          << handler->bounds[1] << " " << handler->bounds[2]
+                          << " " << handler->bounds[3] << std::endl;
+        }
+    }
+    printf("%-40s %10zu files %11zu mismatches\n", "svg_measure",
+           sizeof(cases) / sizeof(cases[0]) + documents.size(), mismatches);
+    return mismatches;
+}
+
+/// symbols that each use the one before ten times, so the last draws 10^n
+/// paths, and a use of that
+std::string make_use_bomb(int levels) {
+    std::string svg = "<svg><symbol id=\"s0\"><path d=\"M0 0 L1 1\"/></symbol>";
+    for (int i = 1; i <= levels; i++) {
+        svg += "<symbol id=\"s" + std::to_string(i) + "\">";
+        for (int j = 0; j < 10; j++) {
+            svg += "<use xlink:href=\"#s" + std::to_string(i - 1) + "\"/>";
+        }
+        svg += "</symbol>";
+    }
+    return svg + "<g><use xlink:href=\"#s" + std::to_string(levels) +
+           "\"/></g></svg>";
+}
+
+/// each limit stops the parse with its status, leaving the handler with
+/// every group and use it was sent ended. returns the number of
+/// mismatches
+size_t check_limits(const std::vector<std::string> &corpus) {
+    using MonkSVG::SVG_Parser;
+    typedef std::chrono::steady_clock clock;
+    const std::string &tiger = corpus.back();
+    const std::string  long_path = make_long_path(64 * 1024);
+    const std::string  bomb = make_use_bomb(9);
+    std::string        deep = "<svg>";
+    for (int i = 0; i < 40; i++)
+        deep += "<g>";
+    deep += "<rect/>";
+    for (int i = 0; i < 40; i++)
+        deep += "</g>";
+    deep += "</svg>";
+    // the use is read before its symbol, so what follows it is played at
+    // the end; the limit comes first
+    std::string forward = "<svg><g><g><use xlink:href=\"#s\"/></g>";
+    for (int i = 0; i < 2000; i++)
+        forward += "<path d=\"M0 0 L1 1\"/>";
+    forward += "</g><symbol id=\"s\"><rect/></symbol></svg>";
+
+    std::atomic<bool> cancelled(true), not_cancelled(false);
+    static const char *statuses[] = {
+        "ok",           "malformed",         "too deep",
+        "deadline",     "cancelled",         "too many elements",
+        "too many segments", "too large"};
+    const struct {
+        const char         *name;
+        const std::string   svg;
+        SVG_Parser::Status  status;
+        std::function<void(SVG_Parser *)> limit;
+    } cases[] = {
+        {"tiger", tiger, SVG_Parser::PARSE_OK,
+         [&](SVG_Parser *parser) {
+             parser->setDeadline(clock::now() + std::chrono::seconds(60));
+             parser->setCancelFlag(&not_cancelled);
+             parser->setMaxElements(1 << 20);
+             parser->setMaxSegments(1 << 20);
+             parser->setMaxBytes(1 << 20);
+         }},
+        {"not xml", "svg", SVG_Parser::PARSE_MALFORMED,
+         [](SVG_Parser *) {}},
+        {"unclosed", "<svg><g><path d='M0 0 L1 1'/></svg>",
+         SVG_Parser::PARSE_MALFORMED, [](SVG_Parser *) {}},
+        {"deep nesting", deep, SVG_Parser::PARSE_TOO_DEEP,
+         [](SVG_Parser *parser) { parser->setMaxDepth(20); }},
+        {"deep uses", bomb, SVG_Parser::PARSE_TOO_DEEP,
+         [](SVG_Parser *parser) { parser->setMaxDepth(4); }},
+        {"past deadline", tiger, SVG_Parser::PARSE_DEADLINE,
+         [](SVG_Parser *parser) { parser->setDeadline(clock::now()); }},
+        {"use bomb deadline", bomb, SVG_Parser::PARSE_DEADLINE,
+         [](SVG_Parser *parser) {
+             parser->setDeadline(clock::now() +
+                                 std::chrono::milliseconds(20));
+         }},
+        {"cancelled", tiger, SVG_Parser::PARSE_CANCELLED,
+         [&](SVG_Parser *parser) { parser->setCancelFlag(&cancelled); }},
+        {"tiger elements", tiger, SVG_Parser::PARSE_TOO_MANY_ELEMENTS,
+         [](SVG_Parser *parser) { parser->setMaxElements(100); }},
+        {"use bomb elements", bomb, SVG_Parser::PARSE_TOO_MANY_ELEMENTS,
+         [](SVG_Parser *parser) { parser->setMaxElements(100000); }},
+        {"forward use elements", forward,
+         SVG_Parser::PARSE_TOO_MANY_ELEMENTS,
+         [](SVG_Parser *parser) { parser->setMaxElements(1000); }},
+        {"long path segments", long_path,
+         SVG_Parser::PARSE_TOO_MANY_SEGMENTS,
+         [](SVG_Parser *parser) { parser->setMaxSegments(1000); }},
+        {"use bomb segments", bomb, SVG_Parser::PARSE_TOO_MANY_SEGMENTS,
+         [](SVG_Parser *parser) { parser->setMaxSegments(100000); }},
+        {"tiger bytes", tiger, SVG_Parser::PARSE_TOO_LARGE,
+         [](SVG_Parser *parser) { parser->setMaxBytes(1000); }},
+    };
+
+    size_t mismatches = 0;
+    auto   check = [&](const char *name, SVG_Parser::ParseResult result,
+                     SVG_Parser::Status status,
+                     const BalanceSVGHandler &handler, double seconds) {
+        bool same = result.status == status && handler.open == 0 &&
+                    !handler.underflow && seconds < 1.0;
+        if (status == SVG_Parser::PARSE_TOO_MANY_SEGMENTS) {
+            // the path past the limit isn't sent
+            same = same && handler.paths * 2 <= result.segments;
+        }
+        if (!same) {
+            if (mismatches++ < 10)
+                std::cerr << "mismatch: " << name << " "
+                          << statuses[result.status] << " after "
+                          << result.elements << " elements "
+                          << result.segments << " segments, "
+                          << handler.open << " left open, " << seconds
+                          << "s" << std::endl;
+        }
+    };
+    for (const auto &c : cases) {
+        auto        handler = std::make_shared<BalanceSVGHandler>();
+        SVG_Parser *parser = SVG_Parser::create(handler);
+        c.limit(parser);
+        clock::time_point       start = clock::now();
+        SVG_Parser::ParseResult result = parser->parse(c.svg);
+        double                  seconds =
+            std::chrono::duration<double>(clock::now() - start).count();
+        SVG_Parser::destroy(parser);
+        check(c.name, result, c.status, *handler, seconds);
+    }
+
+    // cancelled from another thread, part way through
+    {
+        std::atomic<bool> cancel(false);
+        auto              handler = std::make_shared<BalanceSVGHandler>();
+        SVG_Parser       *parser = SVG_Parser::create(handler);
+        parser->setCancelFlag(&cancel);
+        std::thread canceller([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            cancel = true;
+        });
+        clock::time_point       start = clock::now();
+        SVG_Parser::ParseResult result = parser->parse(bomb);
+        double                  seconds =
+            std::chrono::duration<double>(clock::now() - start).count();
+        canceller.join();
+        SVG_Parser::destroy(parser);
+        check("use bomb cancelled", result, SVG_Parser::PARSE_CANCELLED,
+              *handler, seconds);
+    }
+
+    printf("%-40s %10zu parses %10zu mismatches\n", "SVG_Parser limits",
+           sizeof(cases) / sizeof(cases[0]) + 1, mismatches);
+    return mismatches;
+}
+
+/// same value, bit for bit, and same end as strtof for every number that
+/// starts anywhere in the corpus, and for a million generated ones.
+/// returns the number of mismatches
+size_t check_numbers(const std::vector<std::string> &corpus) {
+    std::vector<std::string> numbers;
+    for (const std::string &svg : corpus) {
+        for (size_t i = 0; i < svg.size(); i++) {
+            const char *c = svg.c_str() + i;
+            const char *digits = *c == '+' || *c == '-' ? c + 1 : c;
+            // strtof also reads hex, inf and nan, which svg doesn't have
+            if ((isdigit(*digits) || *digits == '.') &&
+                !(digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')))
+                numbers.push_back(std::string(c, strcspn(c, " \"'<>")));
+        }
+    }
+
+    std::mt19937 random(1);
+    for (int i = 0; i < 1000000; i++) {
+        std::string number = random() % 4 == 0 ? "-" : "";
+        int         length = 1 + random() % 20;
+        int         point = random() % (length + 1);
+        for (int j = 0; j < length; j++) {
+            if (j == point)
+                number += '.';
+            number += char('0' + random() % 10);
+        }
+        if (random() % 3 == 0)
+            number += "e" + std::to_string(int(random() % 100) - 50);
+        numbers.push_back(number);
+    }
+
+    size_t             mismatches = 0;
+    std::vector<float> values;
+    for (const std::string &number : numbers) {
+        float       lexed, expected;
+        char       *expected_end;
+        const char *end = MonkSVG::svg_read_number(number.c_str(), &lexed);
+        expected = strtof(number.c_str(), &expected_end);
+        if (memcmp(&lexed, &expected, sizeof(float)) != 0 ||
+            end != expected_end) {
+            if (mismatches++ < 10)
+                std::cerr << "mismatch: " << number << std::endl;
+        }
+        values.push_back(lexed);
+    }
+
+    // and the same again under a locale with a decimal comma, if one is
+    // installed
+    const char *comma_locales[] = {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8",
+                                   "fr_FR.utf8", "de_DE", "fr_FR"};
+    for (const char *locale : comma_locales) {
+        if (!setlocale(LC_NUMERIC, locale))
+            continue;
+        for (size_t i = 0; i < numbers.size(); i++) {
+            float lexed;
+            MonkSVG::svg_read_number(numbers[i].c_str(), &lexed);
+            if (memcmp(&lexed, &values[i], sizeof(float)) != 0) {
+                if (mismatches++ < 10)
+                    std::cerr << "mismatch in " << locale << ": "
+                              << numbers[i] << std::endl;
+            }
+        }
+        setlocale(LC_NUMERIC, "C");
+        break;
+    }
+    printf("%-40s %10zu numbers %9zu mismatches\n", "svg_read_number vs strtof",
+           numbers.size(), mismatches);
+    return mismatches;
+}
+
+/// a parsed document keeps every kind of string it reads in its arena:
+/// check each reads back right, and that edits after the parse, which put
+/// strings and nodes on the heap, read back too. run under
+/// LeakSanitizer, this also checks that teardown releases all of it.
+/// returns the number of wrong values
+size_t check_document_strings() {
+    const char *xml =
+        "<?xml version=\"1.0\" standalone='yes'?>"
+        "<!DOCTYPE svg>"
+        "<!-- a comment -->"
+        "<svg a=unquoted b=\"x &amp; y\">"
+        "<![CDATA[<raw> & ]]>"
+        "<g>text</g>"
+        "</svg>";
+    size_t        wrong = 0;
+    TiXmlDocument doc;
+    doc.Parse(xml);
+    const TiXmlNode *node = doc.FirstChild();
+    const TiXmlElement *svg = doc.RootElement();
+    if (doc.Error() || !svg || !node->ToDeclaration()) {
+        wrong++;
+    } else {
+        const TiXmlDeclaration *declaration = node->ToDeclaration();
+        wrong += strcmp(declaration->Version(), "1.0") != 0;
+        wrong += strcmp(declaration->Standalone(), "yes") != 0;
+        wrong += strcmp(node->NextSibling()->Value(), "!DOCTYPE svg") != 0;
+        wrong += strcmp(node->NextSibling()->NextSibling()->Value(),
+                        " a comment ") != 0;
+        wrong += strcmp(svg->Attribute("a"), "unquoted") != 0;
+        wrong += strcmp(svg->Attribute("b"), "x & y") != 0;
+        wrong += strcmp(svg->FirstChild()->Value(), "<raw> & ") != 0;
+        wrong += strcmp(svg->FirstChildElement("g")->GetText(), "text") != 0;
+    }
+
+    // edit the parsed tree every way there is, each of which leaves
+    // something for the destructor to release
+    TiXmlDocument edited;
+    edited.Parse(xml);
+    if (TiXmlElement *root = edited.RootElement()) {
+        root->SetValue("a much longer element name than would fit inline");
+        root->SetAttribute("c", "a much longer attribute value than inline");
+        root->FirstAttribute()->SetValue("and a longer replacement value too");
+        root->LinkEndChild(new TiXmlElement("linked"));
+        root->InsertEndChild(TiXmlElement("inserted"));
+        wrong += strcmp(root->Attribute("a"),
+                        "and a longer replacement value too") != 0;
+        wrong += root->LastChild()->ValueStr() != "inserted";
+    } else {
+        wrong++;
+    }
+
+    printf("%-40s %10s %17zu wrong\n", "TiXmlDocument strings", "", wrong);
+    return wrong;
+}
+
+/// every scan kernel must read a document as the byte-at-a-time scan of an
+/// in-situ parse does, wherever its runs of text and white space end in a
+/// vector block. the in-situ buffers are sized exactly, so under
+/// AddressSanitizer this also checks nothing reads past their null.
+/// returns the number of documents read differently
+size_t check_scan_kernels() {
+    std::string kernel = TiXmlBase::ScanKernel();
+    const char *kernels[] = {"avx2", "sse2", "neon", "scalar"};
+    size_t      wrong = 0;
+    for (const char *name : kernels) {
+        if (!TiXmlBase::SetScanKernel(name))
+            continue;
+        for (size_t length = 0; length < 80; length++) {
+            std::string run(length, 'x');
+            std::string space(length, ' ');
+            std::string xml = "<a b=\"" + run + "\"" + space + "c='" + run +
+                              "&amp;'>" + space + run + "</a>" + space;
+
+            TiXmlDocument copied;
+            copied.Parse(xml.c_str());
+            std::vector<char> buffer(xml.begin(), xml.end());
+            buffer.push_back('\0');
+            TiXmlDocument in_situ;
+            in_situ.ParseInSitu(buffer.data());
+            std::string expected, actual;
+            expected << in_situ;
+            actual << copied;
+            wrong += copied.Error() || in_situ.Error() || expected != actual;
+
+            TiXmlReader reader(xml.c_str(), xml.size());
+            wrong += reader.Next() != TiXmlReader::ELEMENT_START ||
+                     reader.Element()->Attribute("b") != run ||
+                     reader.Next() != TiXmlReader::ELEMENT_END ||
+                     reader.Next() != TiXmlReader::DOCUMENT_END;
+        }
+    }
+    TiXmlBase::SetScanKernel(kernel.c_str());
+
+    printf("%-40s %10s %17zu wrong\n", "scan kernels", "", wrong);
+    return wrong;
+}
+
+/// the ways of calling the handler must send it the same things: per call
+/// through the vtable or not, or whole elements, and from a copy of the
+/// svg or in place
+int check_dispatch(const std::vector<std::string> &corpus) {
+    std::vector<std::string> documents = corpus;
+    documents.push_back(make_icon_sheet(10, 50)); // played from tapes
+    int mismatches = 0;
+    for (size_t i = 0; i < documents.size(); i++) {
+        auto virtual_handler = std::make_shared<ChecksumSVGHandler>();
+        MonkSVG::SVG_Parser *parser =
+            MonkSVG::SVG_Parser::create(virtual_handler);
+        parser->parse(documents[i]);
+        MonkSVG::SVG_Parser::destroy(parser);
+
+        auto static_handler = std::make_shared<FinalChecksumSVGHandler>();
+        MonkSVG::SVG_ParserT<FinalChecksumSVGHandler> static_parser(
+            static_handler);
+        static_parser.parse(documents[i]);
+
+        auto batch_handler = std::make_shared<BatchChecksumSVGHandler>();
+        parser = MonkSVG::SVG_Parser::create(batch_handler);
+        parser->parse(documents[i]);
+        MonkSVG::SVG_Parser::destroy(parser);
+
+        // read in place, from a buffer of the caller's
+        std::vector<char> buffer(documents[i].begin(), documents[i].end());
+        buffer.push_back('\0');
+        auto in_situ_handler = std::make_shared<ChecksumSVGHandler>();
+        parser = MonkSVG::SVG_Parser::create(in_situ_handler);
+        parser->parseInSitu(buffer.data(), buffer.size() - 1);
+        MonkSVG::SVG_Parser::destroy(parser);
+
+        if (virtual_handler->sum != static_handler->sum ||
+            virtual_handler->sum != batch_handler->sum ||
+            virtual_handler->sum != in_situ_handler->sum) {
+            std::cerr << "dispatch mismatch: "
+                      << (i < corpus.size() ? corpus_files[i] : "icon sheet")
+                      << std::endl;
+            mismatches++;
+        }
+    }
+    // in place, the svg must be followed by its NUL
+    char unterminated[] = "<svg/>x";
+    auto handler = std::make_shared<ChecksumSVGHandler>();
+    MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+    if (parser->parseInSitu(unterminated, 6).status !=
+        MonkSVG::SVG_Parser::PARSE_MALFORMED) {
+        std::cerr << "dispatch mismatch: unterminated in situ" << std::endl;
+        mismatches++;
+    }
+    MonkSVG::SVG_Parser::destroy(parser);
+
+    printf("%-40s %10zu files %11d mismatches\n",
+           "SVG_ParserT vs create vs batch vs in situ", documents.size(),
+           mismatches);
+    return mismatches;
+}
+
+struct VisitCounts {
+    size_t groups = 0, paths = 0, uses = 0;
+    bool   operator==(const VisitCounts &o) const {
+        return groups == o.groups && paths == o.paths && uses == o.uses;
+    }
+};
+
+void find_symbols(const TiXmlElement *element,
+                  std::map<std::string, const TiXmlElement *> *symbols) {
+    for (const TiXmlElement *child = element->FirstChildElement(); child;
+         child = child->NextSiblingElement()) {
+        if (child->ValueStr() == "symbol" && child->Attribute("id"))
+            (*symbols)[child->Attribute("id")] = child;
+        find_symbols(child, symbols);
+    }
+}
+
+/// what visiting each element once should report: a group for each <g>, a
+/// path for each shape, and a use for each <use>, with its symbol's
+/// content once more
+void count_visits(const TiXmlElement *element,
+                  const std::map<std::string, const TiXmlElement *> &symbols,
+                  VisitCounts *counts) {
+    for (const TiXmlElement *child = element->FirstChildElement(); child;
+         child = child->NextSiblingElement()) {
+        const std::string name = child->ValueStr();
+        if (name == "path" || name == "rect" || name == "polygon" ||
+            name == "polyline") {
+            counts->paths++;
+        } else if (name == "use") {
+            if (const char *href = child->Attribute("xlink:href")) {
+                counts->uses++;
+                auto symbol = symbols.find(href + 1);
+                if (symbol != symbols.end())
+                    count_visits(symbol->second, symbols, counts);
+            }
+        } else if (name != "symbol") {
+            counts->groups += name == "g";
+            count_visits(child, symbols, counts);
+        }
+    }
+}
+
+VisitCounts parse_visits(const std::string &svg) {
+    std::shared_ptr<CountingSVGHandler> handler =
+        std::make_shared<CountingSVGHandler>();
+    MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+    parser->parse(svg);
+    MonkSVG::SVG_Parser::destroy(parser);
+    VisitCounts counts;
+    counts.groups = handler->groups;
+    counts.paths = handler->paths;
+    counts.uses = handler->uses;
+    return counts;
+}
+
+/// the parser sends each element of the corpus once, checked against a
+/// walk of the TinyXML tree. it also stops at the depth limit on deep
+/// nesting, and draws a symbol that uses itself only once. returns the
+/// number of mismatches
+size_t check_visits(const std::vector<std::string> &corpus) {
+    std::vector<std::pair<std::string, VisitCounts>> cases;
+    for (const std::string &svg : corpus) {
+        TiXmlDocument doc;
+        doc.Parse(svg.c_str());
+        std::map<std::string, const TiXmlElement *> symbols;
+        find_symbols(doc.RootElement(), &symbols);
+        VisitCounts expected;
+        count_visits(doc.RootElement(), symbols, &expected);
+        cases.push_back(std::make_pair(svg, expected));
+    }
+
+    std::string deep = "<svg>";
+    for (int i = 0; i < 100000; i++)
+        deep += "<g>";
+    deep += "<rect/>";
+    for (int i = 0; i < 100000; i++)
+        deep += "</g>";
+    VisitCounts limited;
+    limited.groups = 1024;
+    cases.push_back(std::make_pair(deep + "</svg>", limited));
+
+    // a uses b, b uses a; a's use of b draws b, whose use of a is empty
+    const std::string cycle =
+        "<svg><symbol id=\"a\"><rect/><use xlink:href=\"#b\"/></symbol>"
+        "<symbol id=\"b\"><g><use xlink:href=\"#a\"/></g></symbol>"
+        "<use xlink:href=\"#a\"/><use xlink:href=\"#b\"/></svg>";
+    VisitCounts cyclic;
+    cyclic.groups = 2;
+    cyclic.paths = 2;
+    cyclic.uses = 6;
+    cases.push_back(std::make_pair(cycle, cyclic));
+
+    // a use before the symbol it names, and before one that symbol uses
+    const std::string forward =
+        "<svg><g><use xlink:href=\"#a\"/><rect/></g>"
+        "<symbol id=\"a\"><use xlink:href=\"#b\"/></symbol>"
+        "<symbol id=\"b\"><g><rect/></g></symbol></svg>";
+    VisitCounts forwarded;
+    forwarded.groups = 2;
+    forwarded.paths = 2;
+    forwarded.uses = 2;
+    cases.push_back(std::make_pair(forward, forwarded));
+
+    size_t mismatches = 0;
+    for (const auto &c : cases) {
+        VisitCounts visits = parse_visits(c.first);
+        if (!(visits == c.second)) {
+            if (mismatches++ < 10)
+                std::cerr << "mismatch: " << c.first.substr(0, 60)
+                          << ": groups " << visits.groups << " paths "
+                          << visits.paths << " uses " << visits.uses
+                          << std::endl;
+        }
+    }
+    printf("%-40s %10zu files %11zu mismatches\n", "SVG_Parser visits",
+           cases.size(), mismatches);
+    return mismatches;
+}
+
+double parse_checksum(const std::string &svg) {
+    std::shared_ptr<ChecksumSVGHandler> handler =
+        std::make_shared<ChecksumSVGHandler>();
+    MonkSVG::SVG_Parser *parser = MonkSVG::SVG_Parser::create(handler);
+    parser->parse(svg);
+    MonkSVG::SVG_Parser::destroy(parser);
+    return handler->sum;
+}
+
+/// parse the corpus over and over from several threads at once, each parse
+/// with its own parser and handler, and check every result against a
+/// single threaded parse. run under ThreadSanitizer to check for races.
+/// returns the number of mismatched parses
+size_t stress_concurrent(const std::vector<std::string> &corpus,
+                         unsigned threads) {
+    const int           rounds = 20;
+    std::vector<double> expected;
+    size_t              bytes = 0;
+    for (const std::string &svg : corpus) {
+        expected.push_back(parse_checksum(svg));
+        bytes += svg.size();
+    }
+
+    std::atomic<size_t>      mismatches(0);
+    std::vector<std::thread> workers;
+    typedef std::chrono::steady_clock clock;
+    clock::time_point                 start = clock::now();
+    for (unsigned t = 0; t < threads; t++) {
+        workers.push_back(std::thread([&, t]() {
+            for (int round = 0; round < rounds; round++) {
+                // start each thread at a different file
+                for (size_t i = 0; i < corpus.size(); i++) {
+                    size_t file = (i + t) % corpus.size();
+                    if (parse_checksum(corpus[file]) != expected[file])
+                        mismatches++;
+                }
+            }
+        }));
+    }
+    // and switch scan kernels under them the whole time: every kernel must
+    // read the same, and a parse must not mind the switch
+    std::atomic<bool> parsing(true);
+    std::string       kernel = TiXmlBase::ScanKernel();
+    std::thread       switcher([&]() {
+        const char *kernels[] = {"avx2", "sse2", "neon", "scalar"};
+        for (size_t i = 0; parsing; i++) {
+            TiXmlBase::SetScanKernel(kernels[i % 4]);
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    parsing = false;
+    switcher.join();
+    TiXmlBase::SetScanKernel(kernel.c_str());
+
+    double seconds =
+        std::chrono::duration<double>(clock::now() - start).count();
+    double mb = double(bytes) * rounds * threads / (1024.0 * 1024.0);
+    printf("%-40s %10.2f MB/s %12zu mismatches\n",
+           ("SVG_Parser::parse x" + std::to_string(threads) + " threads")
+               .c_str(),
+           mb / seconds, size_t(mismatches));
+    return mismatches;
+}
+
+/// spell out every node and attribute of a tree through the std::string
+/// accessors, which on a tree parsed in-situ read the source buffer
+std::string spell_tree(const TiXmlNode *node) {
+    std::string out = node->ValueStr();
+    if (const TiXmlElement *element = node->ToElement()) {
+        for (const TiXmlAttribute *attrib = element->FirstAttribute(); attrib;
+             attrib = attrib->Next()) {
+            out += " " + attrib->NameTStr() + "=" + attrib->ValueStr();
+        }
+    }
+    for (const TiXmlNode *child = node->FirstChild(); child;
+         child = child->NextSibling()) {
+        out += "(" + spell_tree(child) + ")";
+    }
+    return out;
+}
+
+/// read one document parsed in-situ from several threads at once. reads
+/// are const and must not write the tree, so run under ThreadSanitizer this
+/// reports nothing. returns the number of mismatched reads
+size_t check_shared_reads(const std::vector<std::string> &corpus,
+                          unsigned threads) {
+    size_t mismatches = 0;
+    for (const std::string &svg : corpus) {
+        std::vector<char> buffer(svg.begin(), svg.end());
+        buffer.push_back('\0');
+        TiXmlDocument doc;
+        doc.ParseInSitu(buffer.data());
+        TiXmlDocument copied;
+        copied.Parse(svg.c_str());
+        const std::string expected = spell_tree(&copied);
+
+        std::atomic<size_t>      wrong(0);
+        std::vector<std::thread> readers;
+        for (unsigned t = 0; t < threads; t++) {
+            readers.push_back(std::thread([&]() {
+                if (spell_tree(&doc) != expected)
+                    wrong++;
+            }));
+        }
+        for (std::thread &reader : readers) {
+            reader.join();
+        }
+        mismatches += wrong;
+    }
+    return mismatches;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string data_dir = argc > 1 ? argv[1] : "./data";
+    unsigned    threads = argc > 2 ? unsigned(atoi(argv[2]))
+                                   : std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 4;
+    std::vector<std::string> corpus = load_corpus(data_dir);
+    for (size_t i = 0; i < corpus.size(); i++) {
+        if (corpus[i].empty()) {
+            std::cerr << "ERROR: could not load " << data_dir << "/"
+                      << corpus_files[i] << std::endl;
+            return -1;
+        }
+    }
+
+    if (check_colors() != 0) {
+        std::cerr << "ERROR: svg_read_color misread a color" << std::endl;
+        return -1;
+    }
+    if (check_opacity() != 0) {
+        std::cerr << "ERROR: opacities combined wrongly" << std::endl;
+        return -1;
+    }
+    if (check_style_numbers() != 0) {
+        std::cerr << "ERROR: a style number was misread" << std::endl;
+        return -1;
+    }
+    if (check_normalize() != 0) {
+        std::cerr << "ERROR: paths normalized wrongly" << std::endl;
+        return -1;
+    }
+    if (check_metrics(corpus) != 0) {
+        std::cerr << "ERROR: svg_measure measured wrongly" << std::endl;
+        return -1;
+    }
+    if (check_limits(corpus) != 0) {
+        std::cerr << "ERROR: a parse limit didn't hold" << std::endl;
+        return -1;
+    }
+    if (check_document_strings() != 0) {
+        std::cerr << "ERROR: a parsed document read back wrongly" << std::endl;
+        return -1;
+    }
+    if (check_scan_kernels() != 0) {
+        std::cerr << "ERROR: a scan kernel misread a document" << std::endl;
+        return -1;
+    }
+    if (check_dispatch(corpus) != 0) {
+        std::cerr << "ERROR: SVG_ParserT and SVG_Parser disagree" << std::endl;
+        return -1;
+    }
+    if (check_visits(corpus) != 0) {
+        std::cerr << "ERROR: elements not visited once each" << std::endl;
+        return -1;
+    }
+    if (check_numbers(corpus) != 0) {
+        std::cerr << "ERROR: svg_read_number disagrees with strtof"
+                  << std::endl;
+        return -1;
+    }
+    if (stress_concurrent(corpus, threads) != 0) {
+        std::cerr << "ERROR: concurrent parses disagree" << std::endl;
+        return -1;
+    }
+    if (check_shared_reads(corpus, threads) != 0) {
+        std::cerr << "ERROR: reads of a shared document disagree" << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
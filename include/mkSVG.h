@@ -10,19 +10,100 @@
 #ifndef __mkSVG_h__
 #define __mkSVG_h__
 
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <vector>
 #include <map>
 #include <cmath>
+#include <cstdint>
 #include <memory>
 #include <fstream>
+#include <type_traits>
+#include <mkTransform2d.h>
 
 // class TiXmlDocument;
 // class TiXmlElement;
 
 namespace MonkSVG {
 
-class SVG_Parser_Implementation;
+template <typename Handler> class SVG_ParserT;
+
+/// the segments of an SVGPath, one byte each: the command in the low bits,
+/// and the flags over it
+enum SVGPathCommand {
+    SVG_PATH_CLOSE,           // no coordinates
+    SVG_PATH_MOVE_TO,         // x y
+    SVG_PATH_LINE_TO,         // x y
+    SVG_PATH_HORIZONTAL_LINE, // x
+    SVG_PATH_VERTICAL_LINE,   // y
+    SVG_PATH_CUBIC,           // x1 y1 x2 y2 x3 y3
+    SVG_PATH_SCUBIC,          // x2 y2 x3 y3
+    SVG_PATH_QUAD,            // x1 y1 x2 y2
+    SVG_PATH_SQUAD,           // x2 y2
+    SVG_PATH_ARC,             // rx ry x_axis_rotation x y
+    SVG_PATH_RECT,            // x y w h, for a <rect>
+    SVG_PATH_COMMAND_MASK = 0x0f,
+
+    SVG_PATH_ARC_LARGE = 0x20, // the arc's large-arc-flag
+    SVG_PATH_ARC_SWEEP = 0x40, // the arc's sweep-flag
+    SVG_PATH_RELATIVE = 0x80   // lower case in the path data
+};
+
+/// how many coordinates follow a command in SVGPath::coordinates
+inline int svg_path_coordinates(unsigned char command) {
+    static const unsigned char counts[SVG_PATH_COMMAND_MASK + 1] = {
+        0, 2, 2, 1, 1, 6, 4, 4, 2, 5, 4};
+    return counts[command & SVG_PATH_COMMAND_MASK];
+}
+
+enum SVGFillRule { SVG_FILL_RULE_NONZERO, SVG_FILL_RULE_EVENODD };
+
+/// a string that isn't terminated, and is only good during the callback
+struct SVGStringView {
+    const char *data;
+    size_t      size;
+
+    std::string str() const { return std::string(data, size); }
+};
+
+/// the style, transform and id set on a group, use or path element itself
+struct SVGAttributes {
+    enum {
+        FILL = 1 << 0,
+        STROKE = 1 << 1,
+        STROKE_WIDTH = 1 << 2,
+        FILL_RULE = 1 << 3,
+        FILL_OPACITY = 1 << 4,
+        OPACITY = 1 << 5,
+        STROKE_OPACITY = 1 << 6,
+        TRANSFORM = 1 << 7,
+        FILL_NONE = 1 << 8, // fill="none"; FILL isn't set with it
+        STROKE_NONE = 1 << 9,
+        ID = 1 << 10
+    };
+    unsigned set; // which of the fields below hold a value
+
+    uint32_t    fill_color; // rgba, as onPathFillColor
+    uint32_t    stroke_color;
+    float       stroke_width;
+    SVGFillRule fill_rule;
+    float       fill_opacity;
+    float       opacity; // the fill's alpha is fill_opacity times this
+    float       stroke_opacity;
+    Transform2d transform; // the element's whole transform list
+    SVGStringView id;
+};
+
+/// a path element in one piece: its segments, the coordinates they take in
+/// order, and its attributes. the arrays are only good during the callback
+struct SVGPath {
+    const unsigned char *commands;
+    size_t               command_count;
+    const float         *coordinates;
+    size_t               coordinate_count;
+    SVGAttributes        attributes;
+};
 
 /**
  * @brief Interface for handling SVG elements.
@@ -33,7 +114,8 @@ class ISVGHandler {
   public:
     typedef std::shared_ptr<ISVGHandler> SmartPtr;
 
-    // transforms
+    // transforms. the parser multiplies out a transform attribute's whole
+    // list and delivers it with one onTransformMatrix
     virtual void onTransformTranslate(float x, float y) = 0;
     virtual void onTransformScale(float s) = 0;
     virtual void onTransformRotate(float r) = 0;
@@ -65,6 +147,10 @@ class ISVGHandler {
     virtual void onPathVerticalLine(float y) = 0;
 
     virtual void onPathQuad(float x1, float y1, float x2, float y2) = 0;
+    // a smooth quad, T: its control point is the reflection of the last
+    // one. optional, and dropped unless overridden; a handler that wants
+    // them as onPathQuad can ask for SVG_Parser::NORMALIZE_ABSOLUTE
+    virtual void onPathSQuad(float, float) {}
 
     // fill
     virtual void onPathFillColor(unsigned int color) = 0;
@@ -76,6 +162,14 @@ class ISVGHandler {
     virtual void onPathStrokeOpacity(float o) = 0;
     virtual void onPathStrokeWidth(float width) = 0;
 
+    // whole elements. the parser makes these calls, and the calls above
+    // are made for them by SVGBatchAdapter unless they are overridden: a
+    // group's or use's attributes come before its children, and a path's
+    // segments before its attributes
+    virtual void onGroup(const SVGAttributes &attributes);
+    virtual void onUse(const SVGAttributes &attributes);
+    virtual void onPath(const SVGPath &path);
+
     void setRelative(bool r) { _relative = r; }
     bool relative() const { return _relative; }
 
@@ -85,6 +179,10 @@ class ISVGHandler {
     float width() { return _width; }
     float height() { return _height; }
 
+    // maps the svg's viewBox onto its width and height, as its
+    // preserveAspectRatio says. the identity if there is no viewBox
+    const Transform2d &viewportTransform() const { return _viewport_transform; }
+
     // drawing
     virtual void draw() = 0;
     virtual void dump(void **vertices, size_t *size) = 0;
@@ -99,27 +197,348 @@ class ISVGHandler {
     float _minY;
     float _width;
     float _height;
+    Transform2d _viewport_transform;
 
-    friend class SVG_Parser_Implementation;
+    template <typename Handler> friend class SVG_ParserT;
 
   private:
     bool _relative;
 };
 
+/**
+ * @brief The per-call callbacks for the whole-element ones.
+ *
+ * What ISVGHandler::onGroup, onUse and onPath do unless they are
+ * overridden. Handler is the type the calls are made through.
+ */
+template <typename Handler> struct SVGBatchAdapter {
+    static void group(Handler &h, const SVGAttributes &attributes) {
+        h.onGroupBegin();
+        apply(h, attributes);
+    }
+
+    static void use(Handler &h, const SVGAttributes &attributes) {
+        h.onUseBegin();
+        apply(h, attributes);
+    }
+
+    static void path(Handler &h, const SVGPath &path) {
+        h.onPathBegin();
+        const float *c = path.coordinates;
+        for (size_t i = 0; i < path.command_count; i++) {
+            unsigned char command = path.commands[i];
+            int           type = command & SVG_PATH_COMMAND_MASK;
+            if (type != SVG_PATH_RECT) {
+                h.setRelative((command & SVG_PATH_RELATIVE) != 0);
+            }
+            switch (type) {
+            case SVG_PATH_CLOSE:
+                h.onPathClose();
+                break;
+            case SVG_PATH_MOVE_TO:
+                h.onPathMoveTo(c[0], c[1]);
+                break;
+            case SVG_PATH_LINE_TO:
+                h.onPathLineTo(c[0], c[1]);
+                break;
+            case SVG_PATH_HORIZONTAL_LINE:
+                h.onPathHorizontalLine(c[0]);
+                break;
+            case SVG_PATH_VERTICAL_LINE:
+                h.onPathVerticalLine(c[0]);
+                break;
+            case SVG_PATH_CUBIC:
+                h.onPathCubic(c[0], c[1], c[2], c[3], c[4], c[5]);
+                break;
+            case SVG_PATH_SCUBIC:
+                h.onPathSCubic(c[0], c[1], c[2], c[3]);
+                break;
+            case SVG_PATH_QUAD:
+                h.onPathQuad(c[0], c[1], c[2], c[3]);
+                break;
+            case SVG_PATH_SQUAD:
+                h.onPathSQuad(c[0], c[1]);
+                break;
+            case SVG_PATH_ARC:
+                h.onPathArc(c[0], c[1], c[2],
+                            (command & SVG_PATH_ARC_LARGE) != 0,
+                            (command & SVG_PATH_ARC_SWEEP) != 0, c[3], c[4]);
+                break;
+            case SVG_PATH_RECT:
+                h.onPathRect(c[0], c[1], c[2], c[3]);
+                break;
+            }
+            c += svg_path_coordinates(command);
+        }
+        apply(h, path.attributes);
+        h.onPathEnd();
+    }
+
+    // the style, then the transform and id. the handler has one fill
+    // opacity, so it is sent fill-opacity times opacity, whichever is set
+    static void apply(Handler &h, const SVGAttributes &a) {
+        if (a.set & SVGAttributes::FILL) {
+            h.onPathFillColor(a.fill_color);
+        }
+        if (a.set & SVGAttributes::STROKE) {
+            h.onPathStrokeColor(a.stroke_color);
+        }
+        if (a.set & SVGAttributes::STROKE_WIDTH) {
+            h.onPathStrokeWidth(a.stroke_width);
+        }
+        if (a.set & SVGAttributes::FILL_RULE) {
+            static const std::string rules[] = {"nonzero", "evenodd"};
+            h.onPathFillRule(rules[a.fill_rule]);
+        }
+        if (a.set & (SVGAttributes::FILL_OPACITY | SVGAttributes::OPACITY)) {
+            float fill_opacity =
+                a.set & SVGAttributes::FILL_OPACITY ? a.fill_opacity : 1.0f;
+            float opacity = a.set & SVGAttributes::OPACITY ? a.opacity : 1.0f;
+            h.onPathFillOpacity(fill_opacity * opacity);
+        }
+        if (a.set & SVGAttributes::STROKE_OPACITY) {
+            h.onPathStrokeOpacity(a.stroke_opacity);
+        }
+        if (a.set & SVGAttributes::TRANSFORM) {
+            const Transform2d &m = a.transform;
+            h.onTransformMatrix(m.a, m.b, m.c, m.d, m.e, m.f);
+        }
+        if (a.set & SVGAttributes::ID) {
+            h.onId(a.id.str());
+        }
+    }
+};
+
+inline void ISVGHandler::onGroup(const SVGAttributes &attributes) {
+    SVGBatchAdapter<ISVGHandler>::group(*this, attributes);
+}
+
+inline void ISVGHandler::onUse(const SVGAttributes &attributes) {
+    SVGBatchAdapter<ISVGHandler>::use(*this, attributes);
+}
+
+inline void ISVGHandler::onPath(const SVGPath &path) {
+    SVGBatchAdapter<ISVGHandler>::path(*this, path);
+}
+
+/**
+ * @brief A handler that only takes whole elements.
+ *
+ * Derive from this rather than ISVGHandler to be sent each group, use and
+ * path in one call, with its segments in arrays and its style packed,
+ * instead of one call for each of them.
+ */
+class ISVGBatchHandler : public ISVGHandler {
+  public:
+    virtual void onGroup(const SVGAttributes &attributes) = 0;
+    virtual void onGroupEnd() = 0;
+    virtual void onUse(const SVGAttributes &attributes) = 0;
+    virtual void onUseEnd() = 0;
+    virtual void onPath(const SVGPath &path) = 0;
+
+    // never called: the element calls above aren't split up
+    void onTransformTranslate(float, float) final {}
+    void onTransformScale(float) final {}
+    void onTransformRotate(float) final {}
+    void onTransformMatrix(float, float, float, float, float, float) final {}
+    void onGroupBegin() final {}
+    void onUseBegin() final {}
+    void onId(const std::string &) final {}
+    void onPathBegin() final {}
+    void onPathEnd() final {}
+    void onPathMoveTo(float, float) final {}
+    void onPathClose() final {}
+    void onPathLineTo(float, float) final {}
+    void onPathCubic(float, float, float, float, float, float) final {}
+    void onPathSCubic(float, float, float, float) final {}
+    void onPathArc(float, float, float, int, int, float, float) final {}
+    void onPathRect(float, float, float, float) final {}
+    void onPathHorizontalLine(float) final {}
+    void onPathVerticalLine(float) final {}
+    void onPathQuad(float, float, float, float) final {}
+    void onPathSQuad(float, float) final {}
+    void onPathFillColor(unsigned int) final {}
+    void onPathFillOpacity(float) final {}
+    void onPathFillRule(const std::string &) final {}
+    void onPathStrokeColor(unsigned int) final {}
+    void onPathStrokeOpacity(float) final {}
+    void onPathStrokeWidth(float) final {}
+};
+
+// a final Handler that leaves onGroup, onUse or onPath to ISVGHandler has
+// SVGBatchAdapter called for it directly, so the per-call callbacks it
+// does have bind statically too
+template <typename Handler, bool = std::is_final<Handler>::value>
+struct SVGInheritsBatch {
+    static const bool group = false, use = false, path = false;
+};
+
+template <typename Handler> struct SVGInheritsBatch<Handler, true> {
+    static const bool group =
+        std::is_same<decltype(&Handler::onGroup),
+                     decltype(&ISVGHandler::onGroup)>::value;
+    static const bool use = std::is_same<decltype(&Handler::onUse),
+                                         decltype(&ISVGHandler::onUse)>::value;
+    static const bool path =
+        std::is_same<decltype(&Handler::onPath),
+                     decltype(&ISVGHandler::onPath)>::value;
+};
+
+// h.onGroup(attributes) and the rest, for the parser and the tapes it
+// records
+template <typename Handler>
+void svg_send_group(Handler &h, const SVGAttributes &a, std::true_type) {
+    SVGBatchAdapter<Handler>::group(h, a);
+}
+template <typename Handler>
+void svg_send_group(Handler &h, const SVGAttributes &a, std::false_type) {
+    h.onGroup(a);
+}
+template <typename Handler>
+void svg_send_group(Handler &h, const SVGAttributes &a) {
+    svg_send_group(
+        h, a, std::integral_constant<bool, SVGInheritsBatch<Handler>::group>());
+}
+
+template <typename Handler>
+void svg_send_use(Handler &h, const SVGAttributes &a, std::true_type) {
+    SVGBatchAdapter<Handler>::use(h, a);
+}
+template <typename Handler>
+void svg_send_use(Handler &h, const SVGAttributes &a, std::false_type) {
+    h.onUse(a);
+}
+template <typename Handler>
+void svg_send_use(Handler &h, const SVGAttributes &a) {
+    svg_send_use(
+        h, a, std::integral_constant<bool, SVGInheritsBatch<Handler>::use>());
+}
+
+template <typename Handler>
+void svg_send_path(Handler &h, const SVGPath &path, std::true_type) {
+    SVGBatchAdapter<Handler>::path(h, path);
+}
+template <typename Handler>
+void svg_send_path(Handler &h, const SVGPath &path, std::false_type) {
+    h.onPath(path);
+}
+template <typename Handler> void svg_send_path(Handler &h, const SVGPath &path) {
+    svg_send_path(
+        h, path,
+        std::integral_constant<bool, SVGInheritsBatch<Handler>::path>());
+}
+
 /**
  * @brief SVG Xml Parser
  *
+ * Parsers share no mutable state: separate parsers, each with its own
+ * handler, can run on separate threads at the same time.
+ *
+ * create() makes a parser that calls its handler through the ISVGHandler
+ * vtable. SVG_ParserT, in mkSVGParserT.h, is the same parser for a handler
+ * type known at compile time.
  */
 class SVG_Parser {
   public:
     static SVG_Parser *create(ISVGHandler::SmartPtr handler);
     static void        destroy(SVG_Parser *svg_parser);
 
-    virtual bool parse(const std::string &data) = 0;
-    virtual bool parse(const char *data) = 0;
+    /// how a parse ended
+    enum Status {
+        PARSE_OK,
+        PARSE_MALFORMED, // not an svg, or not well formed xml
+        PARSE_TOO_DEEP,  // elements past setMaxDepth were passed over
+        PARSE_DEADLINE,  // and the rest are the limits below
+        PARSE_CANCELLED,
+        PARSE_TOO_MANY_ELEMENTS,
+        PARSE_TOO_MANY_SEGMENTS,
+        PARSE_TOO_LARGE
+    };
+    struct ParseResult {
+        Status status;
+        size_t elements; // read, and drawn from symbols
+        size_t segments; // of their paths
+
+        // so it can be taken as the bool parse() used to return
+        operator bool() const { return status == PARSE_OK; }
+    };
+
+    /// the svg is read one element at a time and handled as it is read;
+    /// only the open elements and the <symbol>s are kept in memory. the
+    /// reader works in place, so these first take a private copy of the
+    /// whole svg: a parse needs memory for the svg twice over
+    virtual ParseResult parse(const std::string &data) = 0;
+    virtual ParseResult parse(const char *data) = 0;
+
+    /// the same, reading the caller's buffer in place instead of a copy,
+    /// for svgs too large to hold twice. data is size bytes of svg and a
+    /// NUL after them; it is overwritten as it is read, and is of no use
+    /// afterwards. PARSE_MALFORMED if the NUL isn't there
+    virtual ParseResult parseInSitu(char *data, size_t size) = 0;
+
+    /// limits for svgs that can't be trusted, none of them set by default.
+    /// a parse that reaches one stops there: the elements before it have
+    /// been handled, except any after a <use> of a symbol not yet defined,
+    /// and the handler is sent the ends of the groups still open. the
+    /// clock and the cancel flag are looked at every thousand or so
+    /// elements or path segments. a <use> counts what its symbol draws
+    /// before it draws any of it
+    virtual void
+    setDeadline(std::chrono::steady_clock::time_point deadline) = 0;
+    /// the parse stops soon after *cancel is set, from any thread
+    virtual void setCancelFlag(const std::atomic<bool> *cancel) = 0;
+    virtual void setMaxElements(size_t elements) = 0;
+    virtual void setMaxSegments(size_t segments) = 0;
+    /// the most bytes of svg text to take on; a longer one isn't read
+    virtual void setMaxBytes(size_t bytes) = 0;
+
+    /// elements that are never rendered, whose subtrees are passed over
+    /// without being parsed: element names, or a namespace prefix with its
+    /// colon ("sodipodi:"). defaults to defaultSkipList(); an empty list
+    /// parses everything
+    virtual void setSkipList(const std::vector<std::string> &names) = 0;
+    static const std::vector<std::string> &defaultSkipList();
+
+    /// each distinct style and transform attribute string is decoded once
+    /// per parse, and repeats of it are replayed from a cache. these count
+    /// how the caches did in the last parse
+    struct CacheStats {
+        size_t hits;
+        size_t misses;
+        size_t entries; // distinct strings kept
+    };
+    virtual CacheStats styleCacheStats() const = 0;
+    virtual CacheStats transformCacheStats() const = 0;
+
+    /// elements nested deeper than this below the root, counting the
+    /// content a <use> draws as nested inside it, are passed over. 1024 by
+    /// default
+    virtual void setMaxDepth(size_t depth) = 0;
+
+    /// the most distinct strings each cache keeps, 1024 by default; strings
+    /// past that are decoded every time. 0 turns the caches off
+    virtual void setCacheCapacity(size_t entries) = 0;
+
+    /// how path data reaches the handler. NORMALIZE_ABSOLUTE tracks the pen
+    /// so that every coordinate is absolute and H, V, S, T and rects are
+    /// spelled out as L, C, Q and M L L L Z; NORMALIZE_ARCS also turns arcs
+    /// into cubics, which leaves only M, L, C, Q and Z. NORMALIZE_NONE, the
+    /// default, passes the path on as it is written
+    enum PathNormalization {
+        NORMALIZE_NONE = 0,
+        NORMALIZE_ABSOLUTE = 1,
+        NORMALIZE_ARCS = 2 | NORMALIZE_ABSOLUTE
+    };
+    virtual void setPathNormalization(int normalization) = 0;
+
+    /// the SVGAttributes::set bits the handler is sent, all of them by
+    /// default. with none of the style bits in it the style isn't decoded
+    /// at all, which is what a handler that only wants geometry would ask
+    virtual void setAttributeMask(unsigned mask) = 0;
 
   protected:
     SVG_Parser() {}
+    virtual ~SVG_Parser() {}
 };
 } // namespace MonkSVG
 
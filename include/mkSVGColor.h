@@ -0,0 +1,40 @@
+/*
+ *  mkSVGColor.h
+ *  MonkSVG
+ *
+ *  Color parser for fill, stroke and the other paint values in svg.
+ *
+ */
+
+#ifndef __mkSVGColor_h__
+#define __mkSVGColor_h__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MonkSVG {
+
+enum SVGColorKind {
+    SVG_COLOR_INVALID, // not a color, or a paint we don't read (url(...))
+    SVG_COLOR_RGBA,
+    SVG_COLOR_NONE,
+    SVG_COLOR_CURRENT // currentColor
+};
+
+/**
+ * @brief Reads the color in the first length bytes of s.
+ *
+ * Takes #rgb, #rgba, #rrggbb and #rrggbbaa; rgb(), rgba(), hsl() and
+ * hsla() with numbers or percentages, separated by commas or spaces and
+ * with the alpha after a comma or a '/'; the 148 css named colors and
+ * transparent; none and currentColor. Keywords are case insensitive, and
+ * white space around the color is ignored.
+ *
+ * @return what the color is; for SVG_COLOR_RGBA, rgba is set to it packed
+ * as 0xrrggbbaa, and is left alone otherwise.
+ */
+SVGColorKind svg_read_color(const char *s, size_t length, uint32_t *rgba);
+
+} // namespace MonkSVG
+
+#endif // __mkSVGColor_h__
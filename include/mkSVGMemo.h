@@ -0,0 +1,126 @@
+/*
+ *  mkSVGMemo.h
+ *  MonkSVG
+ *
+ *  Memo cache for attribute strings that repeat through a document.
+ *
+ */
+
+#ifndef __mkSVGMemo_h__
+#define __mkSVGMemo_h__
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace MonkSVG {
+
+/**
+ * @brief Maps attribute strings to what they decode to.
+ *
+ * Exported svgs repeat the same style and transform strings over and over;
+ * each distinct string is decoded once and the result is looked up after
+ * that. The keys are copied, into one buffer, so they need not outlive the
+ * document. At
+ * most capacity strings are kept: once it is full, new strings are decoded
+ * every time, and the ones already in it keep being found.
+ */
+template <typename Value> class SVG_MemoCache {
+  public:
+    explicit SVG_MemoCache(size_t capacity)
+        : _capacity(capacity), _hits(0), _misses(0) {}
+
+    /// the value for the first length bytes of key; decode(key, length)
+    /// gives it if the key hasn't been seen
+    template <typename Decode>
+    const Value &get(const char *key, size_t length, Decode decode) {
+        unsigned hash = Hash(key, length);
+        for (size_t slot = hash & mask(); !_slots.empty() && _slots[slot];
+             slot = (slot + 1) & mask()) {
+            const Entry &entry = _entries[_slots[slot] - 1];
+            if (entry.hash == hash && entry.length == length &&
+                memcmp(_keys.data() + entry.offset, key, length) == 0) {
+                _hits++;
+                return entry.value;
+            }
+        }
+
+        _misses++;
+        if (_entries.size() >= _capacity) {
+            _scratch = decode(key, length);
+            return _scratch;
+        }
+        Entry entry = {_keys.size(), length, hash, decode(key, length)};
+        _keys.append(key, length);
+        _entries.push_back(entry);
+        if (_entries.size() * 2 > _slots.size()) {
+            rehash(_slots.empty() ? 16 : _slots.size() * 2);
+        } else {
+            insert_slot(_entries.size() - 1);
+        }
+        return _entries.back().value;
+    }
+
+    /// forgets the strings and zeroes the counters
+    void clear() {
+        _entries.clear();
+        _keys.clear();
+        _slots.clear();
+        _hits = _misses = 0;
+    }
+
+    /// strings already kept stay until clear(); 0 turns the cache off
+    void setCapacity(size_t capacity) { _capacity = capacity; }
+
+    size_t hits() const { return _hits; }
+    size_t misses() const { return _misses; }
+    size_t size() const { return _entries.size(); }
+
+  private:
+    struct Entry {
+        size_t   offset; // of the key in _keys
+        size_t   length;
+        unsigned hash;
+        Value    value;
+    };
+
+    static unsigned Hash(const char *key, size_t length) {
+        // FNV-1a, as TiXmlAtomTable
+        unsigned hash = 2166136261u;
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= (unsigned char)key[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    size_t mask() const { return _slots.size() - 1; }
+
+    void insert_slot(size_t entry) {
+        size_t slot = _entries[entry].hash & mask();
+        while (_slots[slot]) {
+            slot = (slot + 1) & mask();
+        }
+        _slots[slot] = entry + 1;
+    }
+
+    void rehash(size_t slots) {
+        _slots.assign(slots, 0);
+        for (size_t entry = 0; entry < _entries.size(); entry++) {
+            insert_slot(entry);
+        }
+    }
+
+    size_t              _capacity;
+    size_t              _hits;
+    size_t              _misses;
+    std::vector<Entry>  _entries;
+    std::string         _keys;
+    std::vector<size_t> _slots; // open addressing: entry+1, or 0 if empty
+    Value               _scratch; // what get() returns when the cache is full
+};
+
+} // namespace MonkSVG
+
+#endif // __mkSVGMemo_h__
@@ -0,0 +1,73 @@
+/*
+ *  mkSVGMetrics.h
+ *  MonkSVG
+ *
+ *  The bounds and counts of an svg, found without building anything.
+ *
+ */
+
+#ifndef __mkSVGMetrics_h__
+#define __mkSVGMetrics_h__
+
+#include "mkSVG.h"
+
+namespace MonkSVG {
+
+/// what an svg draws, in numbers
+struct SVGMetrics {
+    // the tight box around the paths' geometry, in the svg's viewport: the
+    // viewBox and every transform applied. strokes don't widen it. min_x
+    // is more than max_x if nothing is drawn
+    float min_x, min_y, max_x, max_y;
+
+    size_t paths;    // path, rect, polygon and polyline elements drawn
+    size_t segments; // their segments as written: one for a rect
+    size_t groups;
+    size_t uses;
+};
+
+/**
+ * @brief A handler that only measures.
+ *
+ * Counts each element it is sent, once for each time a <use> draws it,
+ * and grows the bounds by each path under the transforms it is in. It
+ * needs only SVGAttributes::TRANSFORM, so the parser can be told not to
+ * decode any style for it; see svg_measure().
+ */
+class SVG_MetricsHandler final : public ISVGBatchHandler {
+  public:
+    SVG_MetricsHandler();
+
+    const SVGMetrics &metrics() const { return _metrics; }
+
+    void onGroup(const SVGAttributes &attributes);
+    void onGroupEnd();
+    void onUse(const SVGAttributes &attributes);
+    void onUseEnd();
+    void onPath(const SVGPath &path);
+
+    void draw() {}
+    void dump(void **, size_t *) {}
+    void optimize() {}
+
+  private:
+    // the transform the current element's own is applied in
+    const Transform2d &transform() const {
+        return _transforms.empty() ? viewportTransform() : _transforms.back();
+    }
+    void push(const SVGAttributes &attributes);
+
+    SVGMetrics _metrics;
+
+    // of the open groups and uses, each multiplied by those it is in
+    std::vector<Transform2d> _transforms;
+};
+
+/// parses svg for its metrics alone: no style is decoded and nothing is
+/// built. false, with what was read before the error measured, if it
+/// doesn't parse
+bool svg_measure(const std::string &svg, SVGMetrics *metrics);
+
+} // namespace MonkSVG
+
+#endif // __mkSVGMetrics_h__
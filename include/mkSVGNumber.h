@@ -0,0 +1,30 @@
+/*
+ *  mkSVGNumber.h
+ *  MonkSVG
+ *
+ *  Number lexer for path data and the other number lists in svg attributes.
+ *
+ */
+
+#ifndef __mkSVGNumber_h__
+#define __mkSVGNumber_h__
+
+namespace MonkSVG {
+
+/**
+ * @brief Reads one svg number starting at s.
+ *
+ * White space and commas before the number are skipped. The number is
+ * read as far as the svg grammar allows, so compact forms split where
+ * the next number starts: "1.5.5" is 1.5 then .5, "-1-2" is -1 then -2,
+ * and "1e" stops before the 'e'. The value is the nearest float, the same
+ * one strtof() gives in the "C" locale, whatever the current locale is.
+ *
+ * @return the first byte past the number. If there is no number, value is
+ * set to 0 and the return is the first byte after the separators.
+ */
+const char *svg_read_number(const char *s, float *value);
+
+} // namespace MonkSVG
+
+#endif // __mkSVGNumber_h__
@@ -0,0 +1,1581 @@
+/*
+ *  mkSVGParserT.h
+ *  MonkSVG
+ *
+ *  The svg parser, as a template over the handler type it calls.
+ *
+ */
+
+#ifndef __mkSVGParserT_h__
+#define __mkSVGParserT_h__
+
+#include "mkSVG.h"
+#include "mkSVGColor.h"
+#include "mkSVGMemo.h"
+#include "mkSVGNumber.h"
+#include "mkSVGPath.h"
+#include "mkSVGTape.h"
+#include "tinyxml/tinyxml.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <type_traits>
+
+namespace MonkSVG {
+
+// attributes the parser looks up, interned as TinyXML atoms while parsing so
+// a lookup is an integer compare
+enum SVGAttribute {
+    ATTR_X,
+    ATTR_Y,
+    ATTR_WIDTH,
+    ATTR_HEIGHT,
+    ATTR_ID,
+    ATTR_XLINK_HREF,
+    ATTR_D,
+    ATTR_POINTS,
+    ATTR_FILL,
+    ATTR_STROKE,
+    ATTR_STROKE_WIDTH,
+    ATTR_STYLE,
+    ATTR_TRANSFORM,
+    ATTR_OPACITY,
+    ATTR_FILL_OPACITY,
+    ATTR_FILL_RULE,
+    ATTR_STROKE_OPACITY,
+    ATTR_VIEW_BOX,
+    ATTR_PRESERVE_ASPECT_RATIO,
+    ATTR_COUNT
+};
+
+// the tables are function statics, so every translation unit that includes
+// this shares one of each
+inline const TiXmlAtomTable &svg_attribute_atoms() {
+    static const char *const names[ATTR_COUNT] = {
+        "x",         "y",         "width",        "height",
+        "id",        "xlink:href", "d",           "points",
+        "fill",      "stroke",    "stroke-width", "style",
+        "transform", "opacity",   "fill-opacity", "fill-rule",
+        "stroke-opacity", "viewBox", "preserveAspectRatio"};
+    static const TiXmlAtomTable atoms(names, ATTR_COUNT);
+    return atoms;
+}
+
+// the svg element vocabulary, interned as TinyXML element atoms while parsing
+// so dispatch is a switch on TiXmlElement::Atom()
+enum SVGElement {
+    ELEM_SVG,
+    ELEM_G,
+    ELEM_DEFS,
+    ELEM_SYMBOL,
+    ELEM_USE,
+    ELEM_PATH,
+    ELEM_RECT,
+    ELEM_CIRCLE,
+    ELEM_ELLIPSE,
+    ELEM_LINE,
+    ELEM_POLYLINE,
+    ELEM_POLYGON,
+    ELEM_LINEAR_GRADIENT,
+    ELEM_RADIAL_GRADIENT,
+    ELEM_STOP,
+    ELEM_COUNT
+};
+
+inline const TiXmlAtomTable &svg_element_atoms() {
+    static const char *const names[ELEM_COUNT] = {
+        "svg",      "g",       "defs",           "symbol",         "use",
+        "path",     "rect",    "circle",         "ellipse",        "line",
+        "polyline", "polygon", "linearGradient", "radialGradient", "stop"};
+    static const TiXmlAtomTable atoms(names, ELEM_COUNT);
+    return atoms;
+}
+
+// character classes for path data, built at compile time. for a command
+// letter the table also holds how many arguments it takes
+enum PathCharClass {
+    PATH_OTHER = 0,
+    PATH_SEPARATOR = 0x10,
+    PATH_COMMAND = 0x20
+};
+
+struct PathCharTable {
+    unsigned char entries[256];
+};
+
+constexpr PathCharTable make_path_char_table() {
+    PathCharTable table = {};
+    const char *separators = " \t\n\r\f,";
+    for (const char *c = separators; *c; c++) {
+        table.entries[(unsigned char)*c] = PATH_SEPARATOR;
+    }
+    const char *commands = "MmZzLlHhVvCcSsQqTtAa";
+    const int   arguments[] = {2, 0, 2, 1, 1, 6, 4, 4, 2, 7};
+    for (int i = 0; commands[i]; i++) {
+        table.entries[(unsigned char)commands[i]] =
+            PATH_COMMAND | arguments[i / 2];
+    }
+    return table;
+}
+
+inline const PathCharTable &path_char_table() {
+    static constexpr PathCharTable table = make_path_char_table();
+    return table;
+}
+
+inline int path_char_class(char c) {
+    return path_char_table().entries[(unsigned char)c] & 0xf0;
+}
+
+inline int path_command_arguments(char command) {
+    return path_char_table().entries[(unsigned char)command] & 0x0f;
+}
+
+// css properties the style attribute is read for, in the order they are
+// applied: the opacities change the colors, so they come after them
+enum StyleProperty {
+    STYLE_FILL,
+    STYLE_STROKE,
+    STYLE_STROKE_WIDTH,
+    STYLE_FILL_RULE,
+    STYLE_FILL_OPACITY,
+    STYLE_OPACITY,
+    STYLE_STROKE_OPACITY,
+    STYLE_COUNT
+};
+
+constexpr const char *style_property_name(int property) {
+    constexpr const char *names[STYLE_COUNT] = {
+        "fill",         "stroke",  "stroke-width",  "fill-rule",
+        "fill-opacity", "opacity", "stroke-opacity"};
+    return names[property];
+}
+
+// a perfect hash of the names above: each gets a slot of its own
+constexpr unsigned style_hash(const char *name, size_t length) {
+    return (unsigned(length) + 3 * (unsigned char)name[0]) & 15;
+}
+
+constexpr size_t constexpr_strlen(const char *s) {
+    return *s ? 1 + constexpr_strlen(s + 1) : 0;
+}
+
+struct StyleTable {
+    signed char slots[16];
+};
+
+constexpr StyleTable make_style_table() {
+    StyleTable table = {};
+    for (int i = 0; i < 16; i++) {
+        table.slots[i] = -1;
+    }
+    for (int property = 0; property < STYLE_COUNT; property++) {
+        const char *name = style_property_name(property);
+        unsigned    slot = style_hash(name, constexpr_strlen(name));
+        // two names in one slot: pick another hash
+        if (table.slots[slot] != -1)
+            throw "style_hash is not perfect";
+        table.slots[slot] = property;
+    }
+    return table;
+}
+
+// the StyleProperty with the given name, or -1
+inline int style_property(const char *name, size_t length) {
+    static constexpr StyleTable table = make_style_table();
+    if (length == 0) {
+        return -1;
+    }
+    int property = table.slots[style_hash(name, length)];
+    if (property < 0 ||
+        strncmp(style_property_name(property), name, length) != 0 ||
+        style_property_name(property)[length] != 0) {
+        return -1;
+    }
+    return property;
+}
+
+// a set of style properties, decoded, without the strings
+struct StyleRecord {
+    unsigned    set;  // a bit for each StyleProperty that is set
+    unsigned    none; // the same bits, for a fill or stroke of "none"
+    uint32_t    colors[STYLE_STROKE + 1];
+    float       numbers[STYLE_COUNT];
+    SVGFillRule fill_rule;
+};
+
+// a transform attribute, decoded: the functions of its list multiplied
+// together. a list that doesn't parse sets nothing
+struct TransformRecord {
+    bool        set;
+    Transform2d matrix;
+};
+
+// the functions of a transform list, with the argument counts each takes
+enum TransformFunction {
+    TRANSFORM_MATRIX,
+    TRANSFORM_TRANSLATE,
+    TRANSFORM_SCALE,
+    TRANSFORM_ROTATE,
+    TRANSFORM_SKEW_X,
+    TRANSFORM_SKEW_Y,
+    TRANSFORM_COUNT
+};
+
+struct TransformFunctionInfo {
+    const char *name;
+    int         counts; // a bit for each argument count allowed
+};
+
+inline const TransformFunctionInfo &transform_function_info(int function) {
+    static const TransformFunctionInfo functions[TRANSFORM_COUNT] = {
+        {"matrix", 1 << 6},      {"translate", 1 << 1 | 1 << 2},
+        {"scale", 1 << 1 | 1 << 2}, {"rotate", 1 << 1 | 1 << 3},
+        {"skewX", 1 << 1},       {"skewY", 1 << 1}};
+    return functions[function];
+}
+
+// the TransformFunction with the given name, or -1
+inline int transform_function(const char *name, size_t length) {
+    for (int function = 0; function < TRANSFORM_COUNT; function++) {
+        const char *candidate = transform_function_info(function).name;
+        if (strncmp(candidate, name, length) == 0 && candidate[length] == 0) {
+            return function;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief The svg parser, calling a Handler it knows the type of.
+ *
+ * Handler is an ISVGHandler, or a class derived from one. The parser calls
+ * it through a Handler, so when the class is final its callbacks bind
+ * statically and can be inlined into the path lexer; SVG_Parser::create()
+ * is SVG_ParserT<ISVGHandler>, which calls through the vtable.
+ *
+ *     class MyHandler final : public ISVGHandler { ... };
+ *     SVG_ParserT<MyHandler> parser(std::make_shared<MyHandler>());
+ *     parser.parse(svg);
+ */
+template <typename Handler> class SVG_ParserT : public SVG_Parser {
+    static_assert(std::is_base_of<ISVGHandler, Handler>::value,
+                  "the handler must be an ISVGHandler");
+
+  public:
+    explicit SVG_ParserT(std::shared_ptr<Handler> handler)
+        : _handler(handler), _style_cache(1024), _transform_cache(1024),
+          _max_depth(1024), _deadline(Clock::time_point::max()), _cancel(0),
+          _max_elements(std::numeric_limits<size_t>::max()),
+          _max_segments(std::numeric_limits<size_t>::max()),
+          _max_bytes(std::numeric_limits<size_t>::max()),
+          _normalization(NORMALIZE_NONE), _attribute_mask(~0u), _recorder(0),
+          _generation(1), _deferred_groups(0) {
+        setSkipList(defaultSkipList());
+        _path_commands.reserve(256);
+        _path_coordinates.reserve(1024);
+    }
+
+    ~SVG_ParserT() {}
+
+    std::shared_ptr<Handler> _handler;
+
+    // subtrees tinyxml passes over unread; the table points into the names
+    std::vector<std::string>        _skip_names;
+    std::vector<const char *>       _skip_name_ptrs;
+    std::unique_ptr<TiXmlAtomTable> _skip_table;
+
+    void setSkipList(const std::vector<std::string> &names) {
+        _skip_table.reset();
+        _skip_names = names;
+        _skip_name_ptrs.clear();
+        for (const std::string &name : _skip_names) {
+            _skip_name_ptrs.push_back(name.c_str());
+        }
+        if (!_skip_names.empty()) {
+            _skip_table.reset(new TiXmlAtomTable(
+                _skip_name_ptrs.data(), int(_skip_name_ptrs.size())));
+        }
+    }
+
+    // the style and transform strings seen in this parse
+    SVG_MemoCache<StyleRecord>     _style_cache;
+    SVG_MemoCache<TransformRecord> _transform_cache;
+
+    CacheStats styleCacheStats() const { return cache_stats(_style_cache); }
+    CacheStats transformCacheStats() const {
+        return cache_stats(_transform_cache);
+    }
+
+    template <typename Value>
+    static CacheStats cache_stats(const SVG_MemoCache<Value> &cache) {
+        CacheStats stats = {cache.hits(), cache.misses(), cache.size()};
+        return stats;
+    }
+
+    void setCacheCapacity(size_t entries) {
+        _style_cache.setCapacity(entries);
+        _transform_cache.setCapacity(entries);
+    }
+
+    size_t _max_depth;
+
+    void setMaxDepth(size_t depth) { _max_depth = depth; }
+
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point        _deadline;
+    const std::atomic<bool> *_cancel;
+    size_t                   _max_elements;
+    size_t                   _max_segments;
+    size_t                   _max_bytes;
+
+    void setDeadline(Clock::time_point deadline) { _deadline = deadline; }
+    void setCancelFlag(const std::atomic<bool> *cancel) { _cancel = cancel; }
+    void setMaxElements(size_t elements) { _max_elements = elements; }
+    void setMaxSegments(size_t segments) { _max_segments = segments; }
+    void setMaxBytes(size_t bytes) { _max_bytes = bytes; }
+
+    // how the parse is going: the first limit it reached, and what it has
+    // taken on so far
+    Status _status;
+    bool   _too_deep;
+    size_t _elements;
+    size_t _segments;
+    size_t _until_check; // elements and segments until the next poll()
+
+    static const size_t CHECK_INTERVAL = 1024;
+
+    // counts work about to be done. false, and the parse is to stop, once
+    // it is past a limit
+    bool charge(size_t elements, size_t segments) {
+        _elements += elements;
+        _segments += segments;
+        if (_elements > _max_elements) {
+            return stop(PARSE_TOO_MANY_ELEMENTS);
+        }
+        if (_segments > _max_segments) {
+            return stop(PARSE_TOO_MANY_SEGMENTS);
+        }
+        if (_until_check > elements + segments) {
+            _until_check -= elements + segments;
+            return _status == PARSE_OK;
+        }
+        _until_check = CHECK_INTERVAL;
+        return poll();
+    }
+
+    // the limits that aren't counts
+    bool poll() {
+        if (_cancel && _cancel->load(std::memory_order_relaxed)) {
+            return stop(PARSE_CANCELLED);
+        }
+        if (_deadline != Clock::time_point::max() &&
+            Clock::now() >= _deadline) {
+            return stop(PARSE_DEADLINE);
+        }
+        return _status == PARSE_OK;
+    }
+
+    bool stop(Status status) {
+        if (_status == PARSE_OK) {
+            _status = status;
+        }
+        return false;
+    }
+
+    int _normalization;
+
+    void setPathNormalization(int normalization) {
+        _normalization = normalization;
+        if (_normalization & NORMALIZE_ABSOLUTE) {
+            _normal_commands.reserve(_path_commands.capacity());
+            _normal_coordinates.reserve(_path_coordinates.capacity());
+        }
+    }
+
+    unsigned _attribute_mask;
+
+    void setAttributeMask(unsigned mask) { _attribute_mask = mask; }
+
+    // while a symbol, or the document after a forward <use>, is recorded
+    // the calls go here instead of to _handler
+    SVG_TapeRecorder *_recorder;
+
+    // calls call with the handler the calls go to. the two are separate
+    // types, so the calls made through each bind statically
+    template <typename Call> void emit(Call call) {
+        if (_recorder) {
+            call(*_recorder);
+        } else {
+            call(*_handler);
+        }
+    }
+
+    // each <symbol> is recorded as it is read, and only the recording is
+    // kept. ids get a slot when they are first defined or used
+    struct Symbol {
+        SVG_Tape tape;
+        bool     defined;
+        unsigned resolved; // _generation when all it uses was defined
+    };
+    std::vector<std::unique_ptr<Symbol>> _symbols;
+    std::map<std::string, uint32_t>      _symbol_slots;
+    unsigned                             _generation; // of the definitions
+
+    // the document from the first <use> of a symbol not yet defined on,
+    // played at the end once all the symbols are known
+    std::unique_ptr<SVG_Tape>         _deferred;
+    std::unique_ptr<SVG_TapeRecorder> _deferred_recorder;
+    size_t _deferred_groups; // groups open on the handler when it began
+
+    // one entry per element open below the root: is it a group
+    std::vector<bool> _open_groups;
+
+    size_t open_handler_groups() const {
+        return std::count(_open_groups.begin(), _open_groups.end(), true);
+    }
+
+    ParseResult parse(const char *data) {
+        return parse(data, strlen(data));
+    }
+
+    ParseResult parse(const std::string &data) {
+        return parse(data.c_str(), data.size());
+    }
+
+    // copies the svg, which needn't be terminated, and reads the copy.
+    // the reader pads its copy, so it can be scanned with simd
+    ParseResult parse(const char *data, size_t size) {
+        return parse_with(size, [&]() {
+            TiXmlReader reader(data, size);
+            read_svg(reader);
+        });
+    }
+
+    ParseResult parseInSitu(char *data, size_t size) {
+        return parse_with(size, [&]() {
+            if (data[size] != '\0') {
+                std::cerr << "ERROR: svg buffer isn't terminated." << std::endl;
+                stop(PARSE_MALFORMED);
+                return;
+            }
+            TiXmlReader reader(data);
+            read_svg(reader);
+        });
+    }
+
+    // resets the counts, and runs read unless the limits stop it first
+    template <typename Read>
+    ParseResult parse_with(size_t size, const Read &read) {
+        _status = PARSE_OK;
+        _too_deep = false;
+        _elements = 0;
+        _segments = 0;
+        _until_check = CHECK_INTERVAL;
+        if (size > _max_bytes) {
+            stop(PARSE_TOO_LARGE);
+        } else if (poll()) {
+            read();
+        }
+        if (_status == PARSE_OK && _too_deep) {
+            _status = PARSE_TOO_DEEP;
+        }
+        ParseResult result = {_status, _elements, _segments};
+        return result;
+    }
+
+    // stream the svg the reader works on: elements are handled as they
+    // are read, and only the open elements and the <symbol>s are kept.
+    // names and values point straight into the reader's buffer. on a read
+    // error the elements before it have already been handled
+    void read_svg(TiXmlReader &reader) {
+        _style_cache.clear();
+        _transform_cache.clear();
+        _symbols.clear();
+        _symbol_slots.clear();
+        _generation = 1;
+
+        reader.SetAtomTable(&svg_attribute_atoms());
+        reader.SetElementTable(&svg_element_atoms());
+        reader.SetSkipTable(_skip_table.get());
+        // don't depend on the process-wide tinyxml default
+        reader.SetWhiteSpaceCondensed(true);
+
+        if (reader.Next() != TiXmlReader::ELEMENT_START ||
+            reader.Element()->Atom() != ELEM_SVG) {
+            std::cerr << "ERROR: could not parse svg file." << std::endl;
+            stop(PARSE_MALFORMED);
+            return;
+        }
+        handle_bounds(reader.Element());
+
+        std::vector<bool> &open_groups = _open_groups;
+        open_groups.clear();
+        for (;;) {
+            TiXmlReader::Event event = reader.Next();
+            if (event == TiXmlReader::ELEMENT_START) {
+                if (!charge(1, 0)) {
+                    end_groups();
+                    return;
+                }
+                const TiXmlElement *element = reader.Element();
+                size_t              depth = open_groups.size() + 1;
+                if (depth > _max_depth) {
+                    _too_deep = true;
+                    reader.SkipElement();
+                    continue;
+                }
+                if (_recorder) {
+                    _recorder->setDepth(uint32_t(depth));
+                }
+                switch (element->Atom()) {
+                case ELEM_G:
+                    emit([&](auto &h) { handle_group_begin(h, element); });
+                    open_groups.push_back(true);
+                    break;
+                case ELEM_SYMBOL:
+                    if (const TiXmlElement *symbol = reader.ReadElement()) {
+                        handle_symbol(symbol);
+                    }
+                    break;
+                case ELEM_USE:
+                    handle_use(element, depth);
+                    reader.SkipElement();
+                    break;
+                default:
+                    bool handled;
+                    emit([&](auto &h) {
+                        handled = handle_xml_element(h, element);
+                    });
+                    if (handled) {
+                        reader.SkipElement();
+                    } else {
+                        // go into elements we don't handle
+                        open_groups.push_back(false);
+                    }
+                    break;
+                }
+                if (_status != PARSE_OK) {
+                    end_groups();
+                    return;
+                }
+            } else if (event == TiXmlReader::ELEMENT_END) {
+                // the root's own end leaves nothing open
+                if (!open_groups.empty()) {
+                    if (open_groups.back()) {
+                        emit([](auto &h) { h.onGroupEnd(); });
+                    }
+                    open_groups.pop_back();
+                }
+            } else if (event == TiXmlReader::DOCUMENT_END) {
+                play_deferred();
+                return;
+            } else {
+                play_deferred();
+                std::cerr << "ERROR: could not parse svg file." << std::endl;
+                stop(PARSE_MALFORMED);
+                end_groups();
+                return;
+            }
+        }
+    }
+
+    // a parse stopped early: the handler is sent the ends of the groups it
+    // has open. what is still recorded to play later, as when a limit
+    // stops the parse, is dropped
+    void end_groups() {
+        size_t open = open_handler_groups();
+        if (_deferred) {
+            open = _deferred_groups;
+            _recorder = 0;
+            _deferred_recorder.reset();
+            _deferred.reset();
+        }
+        for (size_t i = 0; i < open; i++) {
+            _handler->onGroupEnd();
+        }
+    }
+
+    // get bounds information from the svg file: its position and size in
+    // pixels, and the transform that fits its viewBox into that size. a
+    // missing or percentage width or height is relative to the viewBox, as
+    // there is no other viewport to go by
+    void handle_bounds(const TiXmlElement *root) {
+        float       view_box[4] = {0, 0, 0, 0};
+        bool        has_view_box = false;
+        const char *c = root->AttributeView(ATTR_VIEW_BOX);
+        if (c && read_path_number(&c, &view_box[0]) &&
+            read_path_number(&c, &view_box[1]) &&
+            read_path_number(&c, &view_box[2]) &&
+            read_path_number(&c, &view_box[3])) {
+            // a zero or negative size disables the viewBox
+            has_view_box = view_box[2] > 0 && view_box[3] > 0;
+        }
+        float reference_width = has_view_box ? view_box[2] : 0.0f;
+        float reference_height = has_view_box ? view_box[3] : 0.0f;
+
+        _handler->_minX =
+            parse_length(root->AttributeView(ATTR_X), reference_width, 0);
+        _handler->_minY =
+            parse_length(root->AttributeView(ATTR_Y), reference_height, 0);
+        _handler->_width = parse_length(root->AttributeView(ATTR_WIDTH),
+                                        reference_width, reference_width);
+        _handler->_height = parse_length(root->AttributeView(ATTR_HEIGHT),
+                                         reference_height, reference_height);
+
+        _handler->_viewport_transform.setIdentity();
+        if (has_view_box && _handler->_width > 0 && _handler->_height > 0) {
+            handle_view_box(view_box,
+                            root->AttributeView(ATTR_PRESERVE_ASPECT_RATIO));
+        }
+    }
+
+    // a length in pixels, with 96 pixels to the inch and a 16 pixel font;
+    // percentages are of the reference. anything else is the fallback
+    float parse_length(const char *length, float reference, float fallback) {
+        if (!length) {
+            return fallback;
+        }
+        float       value;
+        const char *unit = skip_style_space(length);
+        const char *end = svg_read_number(unit, &value);
+        if (end == unit) {
+            return fallback;
+        }
+        unit = end;
+        end = trim_style_space(unit, unit + strlen(unit));
+
+        static const struct {
+            const char *name;
+            float       pixels;
+        } units[] = {{"", 1.0f},          {"px", 1.0f},  {"pt", 96.0f / 72},
+                     {"pc", 96.0f / 6},   {"in", 96.0f}, {"cm", 96.0f / 2.54f},
+                     {"mm", 96.0f / 25.4f}, {"em", 16.0f}, {"ex", 8.0f}};
+        if (end - unit == 1 && *unit == '%') {
+            return value * reference / 100.0f;
+        }
+        for (const auto &u : units) {
+            if (size_t(end - unit) == strlen(u.name) &&
+                strncmp(unit, u.name, end - unit) == 0) {
+                return value * u.pixels;
+            }
+        }
+        return fallback;
+    }
+
+    // the viewport transform for a viewBox, following preserveAspectRatio:
+    // "[defer] <align> [meet | slice]", xMidYMid meet if it isn't given
+    void handle_view_box(const float view_box[4],
+                         const char *preserve_aspect_ratio) {
+        float width = _handler->_width;
+        float height = _handler->_height;
+        int   align_x = 1, align_y = 1; // 0 min, 1 mid, 2 max
+        bool  align = true, slice = false;
+
+        if (const char *c = preserve_aspect_ratio) {
+            c = skip_style_space(c);
+            if (strncmp(c, "defer", 5) == 0) {
+                c = skip_style_space(c + 5);
+            }
+            static const char *positions[] = {"Min", "Mid", "Max"};
+            if (strncmp(c, "none", 4) == 0) {
+                align = false;
+                c += 4;
+            } else if (c[0] == 'x' && strlen(c) >= 8 && c[4] == 'Y') {
+                for (int i = 0; i < 3; i++) {
+                    if (strncmp(c + 1, positions[i], 3) == 0)
+                        align_x = i;
+                    if (strncmp(c + 5, positions[i], 3) == 0)
+                        align_y = i;
+                }
+                c += 8;
+            }
+            c = skip_style_space(c);
+            slice = strncmp(c, "slice", 5) == 0;
+        }
+
+        float scale_x = width / view_box[2];
+        float scale_y = height / view_box[3];
+        if (align) {
+            scale_x = scale_y = slice ? std::max(scale_x, scale_y)
+                                      : std::min(scale_x, scale_y);
+        }
+        float x = -view_box[0] * scale_x;
+        float y = -view_box[1] * scale_y;
+        if (align) {
+            x += (width - view_box[2] * scale_x) * align_x / 2;
+            y += (height - view_box[3] * scale_y) * align_y / 2;
+        }
+
+        _handler->_viewport_transform.setScale(scale_x, scale_y);
+        _handler->_viewport_transform.setTranslate(x, y);
+    }
+
+    // a <use> draws the recording of its symbol in its place. if the
+    // symbol, or one it uses, isn't defined yet, the rest of the document
+    // is recorded too and played at the end, when they all are
+    void handle_use(const TiXmlElement *use, size_t depth) {
+        uint32_t slot;
+        if (!use_slot(use, &slot)) {
+            return;
+        }
+        if (!_recorder && !resolved(slot)) {
+            // from the <use> itself on
+            _deferred_groups = open_handler_groups();
+            _deferred.reset(new SVG_Tape);
+            _deferred_recorder.reset(new SVG_TapeRecorder(_deferred.get()));
+            _deferred_recorder->setDepth(uint32_t(depth));
+            _recorder = _deferred_recorder.get();
+        }
+        emit([&](auto &h) { send_use(h, use); });
+        if (_recorder) {
+            _recorder->onInstance(slot);
+            _recorder->onUseEnd();
+        } else {
+            play(slot, depth);
+            _handler->onUseEnd();
+        }
+    }
+
+    // the slot of the symbol a <use> names. false for one without an
+    // href, which draws nothing
+    bool use_slot(const TiXmlElement *use, uint32_t *slot) {
+        const char *href = use->AttributeView(ATTR_XLINK_HREF);
+        if (!href) {
+            return false;
+        }
+        *slot = symbol_slot(*href ? href + 1 : href); // skip the #
+        return true;
+    }
+
+    // calls onUse() with the <use>'s attributes
+    template <typename Target>
+    void send_use(Target &h, const TiXmlElement *use) {
+        SVGAttributes attributes;
+        read_attributes(use, &attributes);
+        svg_send_use(h, attributes);
+    }
+
+    uint32_t symbol_slot(const char *id) {
+        auto found = _symbol_slots.find(id);
+        if (found != _symbol_slots.end()) {
+            return found->second;
+        }
+        uint32_t slot = uint32_t(_symbols.size());
+        _symbols.push_back(std::unique_ptr<Symbol>(new Symbol()));
+        _symbol_slots[id] = slot;
+        return slot;
+    }
+
+    // whether the symbol in slot and all the symbols it uses, and they use
+    // in turn, are defined
+    bool resolved(uint32_t slot) {
+        if (_symbols[slot]->resolved == _generation) {
+            return true;
+        }
+        std::vector<bool>     seen(_symbols.size());
+        std::vector<uint32_t> stack(1, slot);
+        seen[slot] = true;
+        while (!stack.empty()) {
+            const Symbol &symbol = *_symbols[stack.back()];
+            stack.pop_back();
+            if (!symbol.defined) {
+                return false;
+            }
+            for (uint32_t used : symbol.tape.instances()) {
+                if (!seen[used]) {
+                    seen[used] = true;
+                    stack.push_back(used);
+                }
+            }
+        }
+        _symbols[slot]->resolved = _generation;
+        return true;
+    }
+
+    // plays the symbol in slot for a <use> at depth, and the symbols it
+    // uses in turn, with a stack of its own. a symbol that uses itself,
+    // directly or through others, is drawn once rather than forever; one
+    // that isn't defined draws nothing. each symbol is charged for before
+    // it is played, and once the limits are reached no more are started
+    struct Frame {
+        const SVG_Tape *tape;
+        size_t          at;
+        size_t          depth; // of the <use>, the tape's depths add to it
+        uint32_t        slot;
+    };
+
+    std::vector<Frame> _play_stack; // kept from one <use> to the next
+
+    void play(uint32_t slot, size_t depth) {
+        push_instance(&_play_stack, slot, depth);
+        play(&_play_stack);
+    }
+
+    void push_instance(std::vector<Frame> *stack, uint32_t slot,
+                       size_t depth) {
+        const Symbol &symbol = *_symbols[slot];
+        if (!symbol.defined || _status != PARSE_OK) {
+            return;
+        }
+        if (depth + symbol.tape.depth() > _max_depth) {
+            _too_deep = true;
+            if (depth >= _max_depth) {
+                return;
+            }
+        }
+        for (const Frame &frame : *stack) {
+            if (frame.slot == slot) {
+                return;
+            }
+        }
+        if (!charge(symbol.tape.elements(), symbol.tape.segments())) {
+            return;
+        }
+        Frame frame = {&symbol.tape, 0, depth, slot};
+        stack->push_back(frame);
+    }
+
+    void play(std::vector<Frame> *stack) {
+        while (!stack->empty()) {
+            Frame              &top = stack->back();
+            SVG_Tape::Instance instance = {NO_SLOT, 0};
+            top.at = top.tape->play(top.at, _handler.get(),
+                                    long(_max_depth) - long(top.depth),
+                                    &instance);
+            if (instance.slot == NO_SLOT) {
+                stack->pop_back();
+            } else {
+                push_instance(stack, instance.slot,
+                              top.depth + instance.depth);
+            }
+        }
+    }
+
+    static const uint32_t NO_SLOT = uint32_t(-1);
+
+    // the end of the document: what was recorded after a forward <use>
+    void play_deferred() {
+        if (!_deferred) {
+            return;
+        }
+        _recorder = 0;
+        Frame document = {_deferred.get(), 0, 0, NO_SLOT};
+        _play_stack.push_back(document);
+        play(&_play_stack);
+        _deferred_recorder.reset();
+        _deferred.reset();
+    }
+
+    // elements handled from their attributes alone; their children are
+    // ignored
+    template <typename Target>
+    bool handle_xml_element(Target &h, const TiXmlElement *element) {
+        switch (element->Atom()) {
+        case ELEM_PATH:
+            handle_path(h, element);
+            return true;
+        case ELEM_RECT:
+            handle_rect(h, element);
+            return true;
+        case ELEM_POLYGON:
+            handle_polygon(h, element, true);
+            return true;
+        case ELEM_POLYLINE:
+            handle_polygon(h, element, false);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // records the symbol's content for the <use>s that name it, and does
+    // the same for the symbols inside it. depths on the tape start at 1
+    // for the symbol's children
+    void handle_symbol(const TiXmlElement *symbol) {
+        SVG_TapeRecorder *recorder = _recorder;
+
+        std::vector<const TiXmlElement *> symbols(1, symbol);
+        while (!symbols.empty()) {
+            symbol = symbols.back();
+            symbols.pop_back();
+            const char *id = symbol->AttributeView(ATTR_ID);
+            if (!id) {
+                continue;
+            }
+            Symbol &slot = *_symbols[symbol_slot(id)];
+            slot.tape = SVG_Tape();
+            slot.defined = true;
+            _generation++;
+            SVG_TapeRecorder h(&slot.tape);
+            _recorder = &h;
+
+            // one entry per open element: its next child, and whether it
+            // is a group
+            std::vector<std::pair<const TiXmlElement *, bool>> stack;
+            stack.push_back(std::make_pair(symbol->FirstChildElement(), false));
+            while (!stack.empty()) {
+                const TiXmlElement *element = stack.back().first;
+                if (!element) {
+                    if (stack.back().second) {
+                        h.onGroupEnd();
+                    }
+                    stack.pop_back();
+                    continue;
+                }
+                stack.back().first = element->NextSiblingElement();
+                if (!charge(1, 0)) {
+                    symbols.clear();
+                    break;
+                }
+
+                h.setDepth(uint32_t(stack.size()));
+                switch (element->Atom()) {
+                case ELEM_G:
+                    handle_group_begin(h, element);
+                    stack.push_back(
+                        std::make_pair(element->FirstChildElement(), true));
+                    break;
+                case ELEM_SYMBOL:
+                    symbols.push_back(element);
+                    break;
+                case ELEM_USE: {
+                    uint32_t used;
+                    if (use_slot(element, &used)) {
+                        send_use(h, element);
+                        h.onInstance(used);
+                        h.onUseEnd();
+                    }
+                    break;
+                }
+                default:
+                    if (!handle_xml_element(h, element)) {
+                        stack.push_back(
+                            std::make_pair(element->FirstChildElement(), false));
+                    }
+                    break;
+                }
+            }
+        }
+
+        _recorder = recorder;
+    }
+
+    // the children follow, then onGroupEnd()
+    template <typename Target>
+    void handle_group_begin(Target &h, const TiXmlElement *pathElement) {
+        SVGAttributes attributes;
+        read_attributes(pathElement, &attributes);
+        svg_send_group(h, attributes);
+    }
+
+    // the segments of the path being read, kept from one path to the next
+    std::vector<unsigned char> _path_commands;
+    std::vector<float>         _path_coordinates;
+
+    // and the same normalized
+    std::vector<unsigned char> _normal_commands;
+    std::vector<float>         _normal_coordinates;
+
+    // a path's segments are charged for as they are read, so a long one
+    // stops as soon as it is past a limit
+    size_t _path_charged; // of _path_commands
+    size_t _path_check;   // the size to charge for the ones since at
+
+    void begin_path() {
+        _path_commands.clear();
+        _path_coordinates.clear();
+        _path_charged = 0;
+        set_path_check();
+    }
+
+    bool charge_path() {
+        size_t read = _path_commands.size() - _path_charged;
+        _path_charged = _path_commands.size();
+        bool within = charge(0, read);
+        set_path_check();
+        return within;
+    }
+
+    // at the next poll, or the segment past the limit
+    void set_path_check() {
+        size_t left = _segments < _max_segments ? _max_segments - _segments : 0;
+        _path_check = _path_charged + std::min(_until_check - 1, left) + 1;
+    }
+
+    // sends the path read into _path_commands and _path_coordinates, with
+    // the element's attributes, unless it took the parse past a limit
+    template <typename Target>
+    void send_path(Target &h, const TiXmlElement *pathElement) {
+        if (!charge_path()) {
+            return;
+        }
+        SVGPath path;
+        if (_normalization & NORMALIZE_ABSOLUTE) {
+            _normal_commands.clear();
+            _normal_coordinates.clear();
+            svg_normalize_path(_path_commands.data(), _path_commands.size(),
+                               _path_coordinates.data(),
+                               (_normalization & NORMALIZE_ARCS) ==
+                                   NORMALIZE_ARCS,
+                               &_normal_commands, &_normal_coordinates);
+            path.commands = _normal_commands.data();
+            path.command_count = _normal_commands.size();
+            path.coordinates = _normal_coordinates.data();
+            path.coordinate_count = _normal_coordinates.size();
+        } else {
+            path.commands = _path_commands.data();
+            path.command_count = _path_commands.size();
+            path.coordinates = _path_coordinates.data();
+            path.coordinate_count = _path_coordinates.size();
+        }
+        read_attributes(pathElement, &path.attributes);
+        svg_send_path(h, path);
+    }
+
+    template <typename Target>
+    void handle_path(Target &h, const TiXmlElement *pathElement) {
+        begin_path();
+        if (const char *d = pathElement->AttributeView(ATTR_D)) {
+            parse_path_d(d);
+        }
+        send_path(h, pathElement);
+    }
+
+    template <typename Target>
+    void handle_rect(Target &h, const TiXmlElement *pathElement) {
+        float rect[4] = {0, 0, 0, 0}; // x, y, width, height
+        query_float_attribute(pathElement, ATTR_X, &rect[0]);
+        query_float_attribute(pathElement, ATTR_Y, &rect[1]);
+        query_float_attribute(pathElement, ATTR_WIDTH, &rect[2]);
+        query_float_attribute(pathElement, ATTR_HEIGHT, &rect[3]);
+        begin_path();
+        _path_commands.assign(1, SVG_PATH_RECT);
+        _path_coordinates.assign(rect, rect + 4);
+        send_path(h, pathElement);
+    }
+
+    // a polyline is a polygon that isn't closed
+    template <typename Target>
+    void handle_polygon(Target &h, const TiXmlElement *pathElement,
+                        bool closed) {
+        begin_path();
+        if (const char *points = pathElement->AttributeView(ATTR_POINTS)) {
+            parse_points(points, closed);
+        }
+        send_path(h, pathElement);
+    }
+
+    // the attributes are read in one pass. presentation attributes and the
+    // style attribute set the same properties, and style wins, as in css.
+    // only what _attribute_mask asks for is decoded
+    void read_attributes(const TiXmlElement *pathElement,
+                         SVGAttributes *attributes) {
+        const unsigned style_bits =
+            ((1u << STYLE_COUNT) - 1) | SVGAttributes::FILL_NONE |
+            SVGAttributes::STROKE_NONE;
+        const bool  decode = (_attribute_mask & style_bits) != 0;
+        StyleValues style = {};
+        const char *style_attribute = 0;
+        const char *transform = 0;
+        const char *id_ = 0;
+
+        for (const TiXmlAttribute *attribute = pathElement->FirstAttribute();
+             attribute; attribute = attribute->Next()) {
+            int property;
+            switch (attribute->Atom()) {
+            case ATTR_FILL:
+                property = STYLE_FILL;
+                break;
+            case ATTR_STROKE:
+                property = STYLE_STROKE;
+                break;
+            case ATTR_STROKE_WIDTH:
+                property = STYLE_STROKE_WIDTH;
+                break;
+            case ATTR_FILL_RULE:
+                property = STYLE_FILL_RULE;
+                break;
+            case ATTR_FILL_OPACITY:
+                property = STYLE_FILL_OPACITY;
+                break;
+            case ATTR_OPACITY:
+                property = STYLE_OPACITY;
+                break;
+            case ATTR_STROKE_OPACITY:
+                property = STYLE_STROKE_OPACITY;
+                break;
+            case ATTR_STYLE:
+                style_attribute = attribute->Value();
+                continue;
+            case ATTR_TRANSFORM:
+                transform = attribute->Value();
+                continue;
+            case ATTR_ID:
+                id_ = attribute->Value();
+                continue;
+            default:
+                continue;
+            }
+            if (!decode) {
+                continue;
+            }
+            style.values[property] = attribute->Value();
+            style.lengths[property] = strlen(attribute->Value());
+        }
+
+        if (decode) {
+            StyleRecord record = decode_style(style);
+            if (style_attribute) {
+                overlay_style(&record,
+                              _style_cache.get(style_attribute,
+                                               strlen(style_attribute),
+                                               [this](const char *ps, size_t) {
+                                                   StyleValues values = {};
+                                                   read_path_style(ps, &values);
+                                                   return decode_style(values);
+                                               }));
+            }
+            style_attributes(record, attributes);
+            attributes->set &= _attribute_mask;
+        } else {
+            attributes->set = 0;
+        }
+
+        if (transform && (_attribute_mask & SVGAttributes::TRANSFORM)) {
+            const TransformRecord &matrix = _transform_cache.get(
+                transform, strlen(transform),
+                [this](const char *tr, size_t) {
+                    return decode_transform(tr);
+                });
+            if (matrix.set) {
+                attributes->set |= SVGAttributes::TRANSFORM;
+                attributes->transform = matrix.matrix;
+            }
+        }
+
+        if (id_ && (_attribute_mask & SVGAttributes::ID)) {
+            attributes->set |= SVGAttributes::ID;
+            attributes->id.data = id_;
+            attributes->id.size = strlen(id_);
+        } else {
+            attributes->id.data = 0;
+            attributes->id.size = 0;
+        }
+    }
+
+    // like TiXmlElement::QueryFloatAttribute, without the sscanf: value is
+    // left alone if the attribute is missing or doesn't start with a number
+    void query_float_attribute(const TiXmlElement *element, SVGAttribute attribute,
+                               float *value) {
+        const char *c = element->AttributeView(attribute);
+        float       number;
+        if (c && read_path_number(&c, &number)) {
+            *value = number;
+        }
+    }
+
+    // the svg transform list: functions separated by white space or
+    // commas, each one's arguments in parentheses. the functions apply
+    // right to left, so the first is outermost. angles are in degrees. as
+    // the spec says, a list with an error in it is ignored whole
+    TransformRecord decode_transform(const char *tr) {
+        TransformRecord record = TransformRecord();
+        const char     *c = tr;
+        for (;;) {
+            while (path_char_class(*c) == PATH_SEPARATOR) {
+                c++;
+            }
+            if (*c == '\0') {
+                // the end of the list; an empty one sets nothing
+                return record;
+            }
+
+            const char *name = c;
+            while ((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z')) {
+                c++;
+            }
+            int function = transform_function(name, c - name);
+            c = skip_style_space(c);
+            if (function < 0 || *c != '(') {
+                return TransformRecord();
+            }
+            c++;
+
+            float args[7];
+            int   count = 0;
+            while (count < 7 && read_path_number(&c, &args[count])) {
+                count++;
+            }
+            c = skip_style_space(c);
+            if (*c != ')' ||
+                !(transform_function_info(function).counts & (1 << count))) {
+                return TransformRecord();
+            }
+            c++;
+
+            Transform2d t = transform_matrix(function, args, count);
+            Transform2d product;
+            Transform2d::multiply(product, record.matrix, t);
+            record.matrix = product;
+            record.set = true;
+        }
+    }
+
+    static Transform2d transform_matrix(int function, const float *args,
+                                        int count) {
+        const float radians = float(M_PI / 180.0);
+        Transform2d t;
+        switch (function) {
+        case TRANSFORM_MATRIX:
+            t.a = args[0];
+            t.b = args[1];
+            t.c = args[2];
+            t.d = args[3];
+            t.e = args[4];
+            t.f = args[5];
+            break;
+        case TRANSFORM_TRANSLATE:
+            t.setTranslate(args[0], count == 2 ? args[1] : 0);
+            break;
+        case TRANSFORM_SCALE:
+            t.setScale(args[0], count == 2 ? args[1] : args[0]);
+            break;
+        case TRANSFORM_ROTATE:
+            t.setRotation(args[0] * radians);
+            if (count == 3) {
+                // about (cx, cy): translate(cx, cy) rotate translate(-cx, -cy)
+                float cx = args[1], cy = args[2];
+                t.e = cx - t.a * cx - t.c * cy;
+                t.f = cy - t.b * cx - t.d * cy;
+            }
+            break;
+        case TRANSFORM_SKEW_X:
+            t.c = tanf(args[0] * radians);
+            break;
+        case TRANSFORM_SKEW_Y:
+            t.b = tanf(args[0] * radians);
+            break;
+        }
+        return t;
+    }
+
+    // reads the next number of path data into value, past any separators
+    bool read_path_number(const char **c, float *value) {
+        while (path_char_class(**c) == PATH_SEPARATOR) {
+            (*c)++;
+        }
+        const char *end = svg_read_number(*c, value);
+        if (end == *c) {
+            return false;
+        }
+        *c = end;
+        return true;
+    }
+
+    // arc flags are a single '0' or '1', so they may run into what follows
+    bool read_path_flag(const char **c, float *value) {
+        while (path_char_class(**c) == PATH_SEPARATOR) {
+            (*c)++;
+        }
+        if (**c != '0' && **c != '1') {
+            return false;
+        }
+        *value = float(**c - '0');
+        (*c)++;
+        return true;
+    }
+
+    // the svg path grammar: a command letter, then as many sets of
+    // arguments as follow it. each step reads a letter or at least one
+    // number, so the time is linear; as the spec says, the path is drawn
+    // up to the first thing that doesn't fit
+    void parse_path_d(const char *d) {
+        const char   *c = d;
+        char          command = 0; // the one the next arguments belong to
+        unsigned char segment = 0; // and the SVGPathCommand for it
+        float         args[7];
+        for (;;) {
+            if (_path_commands.size() >= _path_check && !charge_path()) {
+                return;
+            }
+            while (path_char_class(*c) == PATH_SEPARATOR) {
+                c++;
+            }
+            if (*c == '\0') {
+                return;
+            }
+
+            if (path_char_class(*c) == PATH_COMMAND) {
+                command = *c++;
+                segment = path_segment(command);
+                if (command == 'z' || command == 'Z') {
+                    _path_commands.push_back(segment);
+                    command = 0; // only a new command can follow
+                    continue;
+                }
+            } else if (command == 0) {
+                return;
+            }
+
+            int count = path_command_arguments(command);
+            for (int i = 0; i < count; i++) {
+                bool is_flag = (command == 'a' || command == 'A') &&
+                               (i == 3 || i == 4);
+                if (!(is_flag ? read_path_flag(&c, &args[i])
+                              : read_path_number(&c, &args[i]))) {
+                    return;
+                }
+            }
+
+            if (command == 'a' || command == 'A') {
+                // the flags go in the command
+                _path_commands.push_back(
+                    segment | (args[3] != 0 ? SVG_PATH_ARC_LARGE : 0) |
+                    (args[4] != 0 ? SVG_PATH_ARC_SWEEP : 0));
+                args[3] = args[5];
+                args[4] = args[6];
+                count = 5;
+            } else {
+                _path_commands.push_back(segment);
+            }
+            _path_coordinates.insert(_path_coordinates.end(), args,
+                                     args + count);
+
+            if (command == 'm' || command == 'M') {
+                // more coordinate pairs are line segments
+                command = command == 'm' ? 'l' : 'L';
+                segment = path_segment(command);
+            }
+        }
+    }
+
+    // the SVGPathCommand for a command letter; lower case is relative
+    // (see SVG spec)
+    static unsigned char path_segment(char command) {
+        unsigned char segment = SVG_PATH_CLOSE;
+        switch (command | 0x20) {
+        case 'm':
+            segment = SVG_PATH_MOVE_TO;
+            break;
+        case 'l':
+            segment = SVG_PATH_LINE_TO;
+            break;
+        case 'h':
+            segment = SVG_PATH_HORIZONTAL_LINE;
+            break;
+        case 'v':
+            segment = SVG_PATH_VERTICAL_LINE;
+            break;
+        case 'c':
+            segment = SVG_PATH_CUBIC;
+            break;
+        case 's':
+            segment = SVG_PATH_SCUBIC;
+            break;
+        case 'q':
+            segment = SVG_PATH_QUAD;
+            break;
+        case 't':
+            segment = SVG_PATH_SQUAD;
+            break;
+        case 'a':
+            segment = SVG_PATH_ARC;
+            break;
+        }
+        return command >= 'a' ? segment | SVG_PATH_RELATIVE : segment;
+    }
+
+    // the presentation properties of an element, as views of its attribute
+    // values and style declarations. unset properties are null
+    struct StyleValues {
+        const char *values[STYLE_COUNT];
+        size_t      lengths[STYLE_COUNT];
+    };
+
+    // semicolon-separated property declarations of the form "name : value"
+    // within the ‘style’ attribute, read in one pass. each one replaces what
+    // the property was set to
+    void read_path_style(const char *ps, StyleValues *style) {
+        for (const char *c = ps; *c;) {
+            const char *name = skip_style_space(c);
+            const char *colon = name;
+            while (*colon && *colon != ':' && *colon != ';') {
+                colon++;
+            }
+            const char *end = colon;
+            while (*end && *end != ';') {
+                end++;
+            }
+
+            // a declaration without a ':' is ignored
+            if (*colon == ':') {
+                int property =
+                    style_property(name, trim_style_space(name, colon) - name);
+                const char *value = skip_style_space(colon + 1);
+                if (property >= 0 && value < end) {
+                    style->values[property] = value;
+                    style->lengths[property] =
+                        trim_style_space(value, end) - value;
+                }
+            }
+            c = *end ? end + 1 : end;
+        }
+    }
+
+    StyleRecord decode_style(const StyleValues &style) {
+        StyleRecord record = {};
+        for (int property = 0; property < STYLE_COUNT; property++) {
+            if (!style.values[property]) {
+                continue;
+            }
+            // the values aren't terminated, and a presentation attribute's
+            // isn't trimmed
+            const char *value = skip_style_space(style.values[property]);
+            const char *value_end = trim_style_space(
+                value, style.values[property] + style.lengths[property]);
+            const size_t length = value_end - value;
+
+            record.set |= 1u << property;
+            switch (property) {
+            case STYLE_FILL:
+            case STYLE_STROKE:
+                switch (svg_read_color(style.values[property],
+                                       style.lengths[property],
+                                       &record.colors[property])) {
+                case SVG_COLOR_RGBA:
+                    break;
+                case SVG_COLOR_NONE:
+                    record.none |= 1u << property;
+                    break;
+                case SVG_COLOR_CURRENT:
+                    // there is no color property to take it from; black is
+                    // its initial value
+                    record.colors[property] = 0x000000ff;
+                    break;
+                case SVG_COLOR_INVALID:
+                    // gradients, or a bad value: the property isn't set
+                    record.set &= ~(1u << property);
+                    break;
+                }
+                break;
+            case STYLE_FILL_RULE:
+                if (length == 7 && strncmp(value, "nonzero", 7) == 0) {
+                    record.fill_rule = SVG_FILL_RULE_NONZERO;
+                } else if (length == 7 && strncmp(value, "evenodd", 7) == 0) {
+                    record.fill_rule = SVG_FILL_RULE_EVENODD;
+                } else {
+                    record.set &= ~(1u << property);
+                }
+                break;
+            default: {
+                // one number and nothing else, though a width may give its
+                // unit as px. svg_read_number would skip a leading comma
+                float       number;
+                const char *end = svg_read_number(value, &number);
+                if (property == STYLE_STROKE_WIDTH && value_end - end == 2 &&
+                    strncmp(end, "px", 2) == 0) {
+                    end = value_end;
+                }
+                if (*value == ',' || end == value || end != value_end) {
+                    record.set &= ~(1u << property);
+                } else {
+                    record.numbers[property] = number;
+                }
+                break;
+            }
+            }
+        }
+        return record;
+    }
+
+    // the properties set in over replace those in under
+    static void overlay_style(StyleRecord *under, const StyleRecord &over) {
+        for (int property = 0; property < STYLE_COUNT; property++) {
+            unsigned bit = 1u << property;
+            if (over.set & bit) {
+                under->none = (under->none & ~bit) | (over.none & bit);
+                if (property <= STYLE_STROKE) {
+                    under->colors[property] = over.colors[property];
+                }
+                under->numbers[property] = over.numbers[property];
+            }
+        }
+        if (over.set & (1u << STYLE_FILL_RULE)) {
+            under->fill_rule = over.fill_rule;
+        }
+        under->set |= over.set;
+    }
+
+    // the style part of an element's attributes
+    static void style_attributes(const StyleRecord &style,
+                                 SVGAttributes *attributes) {
+        static_assert(SVGAttributes::FILL == 1 << STYLE_FILL &&
+                          SVGAttributes::STROKE_OPACITY ==
+                              1 << STYLE_STROKE_OPACITY,
+                      "the StyleProperty bits are the SVGAttributes ones");
+        attributes->set = style.set & ~style.none;
+        if (style.set & style.none & (1u << STYLE_FILL)) {
+            attributes->set |= SVGAttributes::FILL_NONE;
+        }
+        if (style.set & style.none & (1u << STYLE_STROKE)) {
+            attributes->set |= SVGAttributes::STROKE_NONE;
+        }
+        attributes->fill_color = style.colors[STYLE_FILL];
+        attributes->stroke_color = style.colors[STYLE_STROKE];
+        attributes->stroke_width = style.numbers[STYLE_STROKE_WIDTH];
+        attributes->fill_rule = style.fill_rule;
+        attributes->fill_opacity = style.numbers[STYLE_FILL_OPACITY];
+        attributes->opacity = style.numbers[STYLE_OPACITY];
+        attributes->stroke_opacity = style.numbers[STYLE_STROKE_OPACITY];
+    }
+
+    static const char *skip_style_space(const char *c) {
+        while (*c == ' ' || *c == '\t' || *c == '\n' || *c == '\r' ||
+               *c == '\f') {
+            c++;
+        }
+        return c;
+    }
+
+    // the end of [begin, end) without its trailing white space
+    static const char *trim_style_space(const char *begin, const char *end) {
+        while (end > begin && (end[-1] == ' ' || end[-1] == '\t' ||
+                               end[-1] == '\n' || end[-1] == '\r' ||
+                               end[-1] == '\f')) {
+            end--;
+        }
+        return end;
+    }
+
+    // the coordinate pairs of a polygon or polyline, with the same number
+    // lexer as path data. an odd number at the end is ignored, as the spec
+    // says
+    void parse_points(const char *points, bool closed) {
+        const char *c = points;
+        float       xy[2];
+        bool        first = true;
+        for (; read_path_number(&c, &xy[0]) && read_path_number(&c, &xy[1]);
+             first = false) {
+            if (_path_commands.size() >= _path_check && !charge_path()) {
+                return;
+            }
+            _path_commands.push_back(first ? SVG_PATH_MOVE_TO
+                                           : SVG_PATH_LINE_TO);
+            _path_coordinates.insert(_path_coordinates.end(), xy, xy + 2);
+        }
+        // with no pair there is no subpath to close
+        if (closed && !first) {
+            _path_commands.push_back(SVG_PATH_CLOSE);
+        }
+    }
+};
+
+} // namespace MonkSVG
+
+#endif // __mkSVGParserT_h__
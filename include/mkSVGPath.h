@@ -0,0 +1,54 @@
+/*
+ *  mkSVGPath.h
+ *  MonkSVG
+ *
+ *  Path data normalized to absolute, fully spelled out segments, and the
+ *  bounds of paths in that form.
+ *
+ */
+
+#ifndef __mkSVGPath_h__
+#define __mkSVGPath_h__
+
+#include "mkSVG.h"
+#include <cstddef>
+#include <vector>
+
+namespace MonkSVG {
+
+/**
+ * @brief Rewrites a path's segments so they can be drawn without any state.
+ *
+ * The pen is tracked through the segments: every coordinate comes out
+ * absolute, H and V become L, S becomes C and T becomes Q with their
+ * reflected control points, and a rect becomes M L L L Z (nothing for an
+ * empty one). With arcs_to_cubics, each arc becomes the cubics that
+ * approximate it, at most a quarter turn each; a zero radius makes it an
+ * L, and an arc that ends where it starts is dropped, as the spec says.
+ * Otherwise arcs keep their radii, rotation and flags.
+ *
+ * The result is appended to commands_out and coordinates_out, in the form
+ * of SVGPath, without SVG_PATH_RELATIVE.
+ */
+void svg_normalize_path(const unsigned char *commands, size_t command_count,
+                        const float *coordinates, bool arcs_to_cubics,
+                        std::vector<unsigned char> *commands_out,
+                        std::vector<float>         *coordinates_out);
+
+/**
+ * @brief Grows bounds to take in a path drawn through a transform.
+ *
+ * The path may be in any form SVGPath takes; it is walked as
+ * svg_normalize_path would write it, without being copied. The box is
+ * tight: each segment is mapped through transform and solved for where
+ * it turns, so a curve counts only as far as it goes and not its control
+ * points, and a point only moved to doesn't count. bounds is min x,
+ * min y, max x, max y.
+ */
+void svg_path_bounds(const unsigned char *commands, size_t command_count,
+                     const float *coordinates, const Transform2d &transform,
+                     float bounds[4]);
+
+} // namespace MonkSVG
+
+#endif // __mkSVGPath_h__
@@ -0,0 +1,187 @@
+/*
+ *  mkSVGTape.h
+ *  MonkSVG
+ *
+ *  Handler calls recorded once, to be played back as many times as needed.
+ *
+ */
+
+#ifndef __mkSVGTape_h__
+#define __mkSVGTape_h__
+
+#include "mkSVG.h"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MonkSVG {
+
+/**
+ * @brief A recorded run of ISVGHandler calls.
+ *
+ * A <symbol> is recorded once and every <use> of it plays the recording,
+ * so the paths and paints in it are parsed only once. A <use> inside the
+ * recording is kept as an instance of the symbol it names, by slot, for
+ * whoever plays the tape to resolve; the tape itself never changes once
+ * recorded.
+ *
+ * Each group, use and path is recorded with the depth of its element, so
+ * playing the tape can pass over the ones nested too deep.
+ */
+class SVG_Tape {
+  public:
+    /// a <use> found while playing: the symbol slot it names and the depth
+    /// of the <use>
+    struct Instance {
+        uint32_t slot;
+        uint32_t depth;
+    };
+
+    /// calls handler for the recording from at, passing over the groups,
+    /// uses and paths deeper than max_depth. stops after the first
+    /// instance, which is set, and returns where to carry on from; returns
+    /// size() at the end
+    template <typename Handler>
+    size_t play(size_t at, Handler *handler, long max_depth,
+                Instance *instance) const;
+
+    size_t size() const { return _words.size(); }
+
+    /// what playing the tape through once draws: its groups, uses and
+    /// paths, and the segments of the paths, not counting the instances
+    size_t elements() const { return _attributes.size(); }
+    size_t segments() const { return _commands.size(); }
+
+    /// the depth of the deepest element on it
+    uint32_t depth() const { return _depth; }
+
+    /// the slots of the symbols this tape draws instances of
+    const std::vector<uint32_t> &instances() const { return _instances; }
+
+  private:
+    friend class SVG_TapeRecorder;
+
+    enum Op {
+        OP_GROUP_BEGIN, // depth, end, attributes
+        OP_GROUP_END,
+        OP_USE_BEGIN, // depth, end, attributes
+        OP_USE_END,
+        OP_INSTANCE, // slot, depth
+        OP_PATH, // depth, attributes, commands, command count, coordinates,
+                 // coordinate count
+    };
+
+    // the attributes at index, with their id
+    SVGAttributes attributes(uint32_t index) const {
+        SVGAttributes attributes = _attributes[index];
+        if (attributes.set & SVGAttributes::ID) {
+            const std::string &id = _strings[_ids[index]];
+            attributes.id.data = id.data();
+            attributes.id.size = id.size();
+        }
+        return attributes;
+    }
+
+    // ops, each followed by its operands; the attributes and path
+    // segments are kept apart, and the ops hold indices into them
+    std::vector<uint32_t>      _words;
+    std::vector<SVGAttributes> _attributes; // without the id pointers
+    std::vector<uint32_t>      _ids;        // each one's id in _strings
+    std::vector<std::string>   _strings;
+    std::vector<unsigned char> _commands;
+    std::vector<float>         _coordinates;
+    std::vector<uint32_t>      _instances;
+    uint32_t                   _depth = 0;
+};
+
+/**
+ * @brief Records what it is sent onto a tape.
+ *
+ * Give the parser one in place of the real handler, and tell it the depth
+ * of each element before the element's calls.
+ */
+class SVG_TapeRecorder final : public ISVGBatchHandler {
+  public:
+    explicit SVG_TapeRecorder(SVG_Tape *tape);
+
+    /// the depth of the element the next calls are for
+    void setDepth(uint32_t depth) { _depth = depth; }
+
+    /// a <use> of the symbol in slot, between its onUse and onUseEnd
+    void onInstance(uint32_t slot);
+
+    void onGroup(const SVGAttributes &attributes);
+    void onGroupEnd();
+    void onUse(const SVGAttributes &attributes);
+    void onUseEnd();
+    void onPath(const SVGPath &path);
+
+    void draw() {}
+    void dump(void **, size_t *) {}
+    void optimize() {}
+
+  private:
+    uint32_t attributes(const SVGAttributes &attributes);
+    void     begin(SVG_Tape::Op op, const SVGAttributes &attributes);
+    void     end(SVG_Tape::Op op);
+
+    SVG_Tape           *_tape;
+    uint32_t            _depth;
+    std::vector<size_t> _open; // where the open begins want their ends
+};
+
+// the calls are made through a Handler, so they bind statically when it is
+// final
+template <typename Handler>
+size_t SVG_Tape::play(size_t at, Handler *handler, long max_depth,
+                      Instance *instance) const {
+    const uint32_t *w = _words.data();
+    while (at < _words.size()) {
+        switch (w[at]) {
+        case OP_GROUP_BEGIN:
+        case OP_USE_BEGIN:
+            // begins that are too deep skip to their end
+            if (long(w[at + 1]) > max_depth) {
+                at = std::min(size_t(w[at + 2]), _words.size());
+                continue;
+            }
+            if (w[at] == OP_GROUP_BEGIN) {
+                svg_send_group(*handler, attributes(w[at + 3]));
+            } else {
+                svg_send_use(*handler, attributes(w[at + 3]));
+            }
+            at += 4;
+            break;
+        case OP_GROUP_END:
+            handler->onGroupEnd();
+            at += 1;
+            break;
+        case OP_USE_END:
+            handler->onUseEnd();
+            at += 1;
+            break;
+        case OP_INSTANCE:
+            instance->slot = w[at + 1];
+            instance->depth = w[at + 2];
+            return at + 3;
+        case OP_PATH:
+            if (long(w[at + 1]) <= max_depth) {
+                SVGPath path;
+                path.commands = _commands.data() + w[at + 3];
+                path.command_count = w[at + 4];
+                path.coordinates = _coordinates.data() + w[at + 5];
+                path.coordinate_count = w[at + 6];
+                path.attributes = attributes(w[at + 2]);
+                svg_send_path(*handler, path);
+            }
+            at += 7;
+            break;
+        }
+    }
+    return at;
+}
+
+} // namespace MonkSVG
+
+#endif // __mkSVGTape_h__
@@ -71,6 +71,10 @@ class OpenVG_SVGHandler : public ISVGHandler {
     virtual void onPathRect(float x, float y, float w, float h);
 
     virtual void onPathQuad(float x1, float y1, float x2, float y2);
+    virtual void onPathSQuad(float x2, float y2);
+
+    // the whole path, appended to the VGPath in one call
+    virtual void onPath(const SVGPath &path);
 
     // paint
     virtual void onPathFillColor(unsigned int color);
@@ -173,6 +177,8 @@ class OpenVG_SVGHandler : public ISVGHandler {
     VGPaint _blackBackFill; // if a path doesn't have a stroke or a fill then
                             // use this fill
 
+    std::vector<VGubyte> _segments; // onPath's, kept from path to path
+
     /// optimized batch monkvg batch object
     VGBatchMNK _batch;
 
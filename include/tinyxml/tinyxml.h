@@ -37,6 +37,7 @@ distribution.
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <new>
 
 // Help out windows:
 #if defined( _DEBUG ) && !defined( DEBUG )
@@ -88,6 +89,7 @@ class TiXmlAttribute;
 class TiXmlText;
 class TiXmlDeclaration;
 class TiXmlParsingData;
+class TiXmlReader;
 
 const int TIXML_MAJOR_VERSION = 2;
 const int TIXML_MINOR_VERSION = 6;
@@ -106,6 +108,126 @@ struct TiXmlCursor
 };
 
 
+/*	A bump allocator. TiXmlDocument creates the nodes and attributes it
+	parses, and any strings they can't share with the source buffer, out
+	of large blocks which are only ever released all at once, by Clear()
+	or the destructor. Objects in the arena are destroyed, never deleted,
+	and a tree that is only parsed owns nothing outside it, so the document
+	can release the whole tree without visiting a node.
+*/
+class TiXmlArena
+{
+public:
+	TiXmlArena() : blocks( 0 ), cursor( 0 ), end( 0 ), nextSize( MIN_BLOCK_SIZE ) {}
+	~TiXmlArena()	{ Clear(); }
+
+	/// Memory for an object of the given size, suitably aligned.
+	void* Alloc( size_t size );
+	/// Copy of the first length chars of str, null terminated.
+	char* StrDup( const char* str, size_t length );
+	/// As StrDup(), but aligned and padded with nulls for TiXmlPaddedScan.
+	char* PaddedDup( const char* str, size_t length );
+	/// Release every block. Everything allocated from the arena is gone.
+	void Clear();
+	/// Like Clear(), but keeps the newest block to allocate from again.
+	void Rewind();
+
+private:
+	TiXmlArena( const TiXmlArena& );			// not implemented.
+	void operator=( const TiXmlArena& );		// not allowed.
+
+	char* Grab( size_t size, size_t align );
+
+	enum
+	{
+		MIN_BLOCK_SIZE = 4 * 1024,
+		MAX_BLOCK_SIZE = 64 * 1024
+	};
+
+	struct Block
+	{
+		Block* next;
+		double align;
+	};
+
+	Block*	blocks;
+	char*	cursor;
+	char*	end;
+	size_t	nextSize;
+};
+
+
+/*	The vector scanners in tinyxmlscan.cpp read whole aligned blocks, so
+	they touch bytes before the one they start at and after the null that
+	ends the text. They only run over buffers the parser copied for itself,
+	which start on an ALIGN boundary and run on in nulls to Size(): while a
+	TiXmlPaddedScan is in scope, scans that start inside its buffer use
+	them. Every other scan, on this thread or any other, goes a byte at a
+	time.
+*/
+class TiXmlPaddedScan
+{
+public:
+	enum { ALIGN = 32 };
+
+	/// Padded size of a copy of length chars and their null.
+	static size_t Size( size_t length )	{ return ( length + ALIGN ) & ~(size_t)( ALIGN - 1 ); }
+
+	/// An empty buffer (size 0) turns the vector scanners off until this ends.
+	TiXmlPaddedScan( const char* buffer, size_t size );
+	~TiXmlPaddedScan();
+
+	/// True if a scan can start at p with a vector scanner.
+	static bool Covers( const char* p );
+
+private:
+	TiXmlPaddedScan( const TiXmlPaddedScan& );		// not implemented.
+	void operator=( const TiXmlPaddedScan& );		// not allowed.
+
+	const char*				begin;
+	const char*				end;
+	const TiXmlPaddedScan*	outer;
+};
+
+
+/**	Interns a fixed set of attribute names as small integers, or atoms.
+	Give one to a TiXmlDocument before parsing, and every attribute whose
+	name is in the table is tagged with its atom; TiXmlElement::FindAttribute()
+	then finds it with an integer compare rather than a strcmp. A table of
+	element names does the same for elements; see TiXmlElement::Atom().
+
+	The names are not copied, and the table must outlive the documents that
+	use it. It is never modified once built, so any number of documents, on
+	any number of threads, may share one.
+*/
+class TiXmlAtomTable
+{
+public:
+	/// names[i] becomes atom i.
+	TiXmlAtomTable( const char* const* names, int count );
+	~TiXmlAtomTable()	{ delete [] slots; }
+
+	/// The atom for the first length chars of name, or TIXML_NO_ATOM.
+	int Find( const char* name, size_t length ) const;
+	/// The atom for name, or TIXML_NO_ATOM.
+	int Find( const char* name ) const		{ return Find( name, strlen( name ) ); }
+
+	int Count() const						{ return count; }
+	const char* Name( int atom ) const		{ return names[atom]; }
+
+private:
+	TiXmlAtomTable( const TiXmlAtomTable& );	// not implemented.
+	void operator=( const TiXmlAtomTable& );	// not allowed.
+
+	static unsigned Hash( const char* name, size_t length );
+
+	const char* const* names;
+	int count;
+	int* slots;		// open addressing: atom+1, or 0 for an empty slot
+	unsigned mask;	// slot count - 1
+};
+
+
 /**
 	Implements the interface to the "Visitor pattern" (see the Accept() method.)
 	If you call the Accept() method, it requires being passed a TiXmlVisitor
@@ -158,6 +280,9 @@ enum
 	TIXML_WRONG_TYPE
 };
 
+// The atom of an attribute whose name isn't in the document's TiXmlAtomTable.
+const int TIXML_NO_ATOM = -1;
+
 
 // Used by the parsing routines.
 enum TiXmlEncoding
@@ -196,9 +321,11 @@ class TiXmlBase
 	friend class TiXmlNode;
 	friend class TiXmlElement;
 	friend class TiXmlDocument;
+	friend class TiXmlParsingData;
+	friend class TiXmlReader;
 
 public:
-	TiXmlBase()	:	userData(0)		{}
+	TiXmlBase()	:	userData(0), inArena(false)	{}
 	virtual ~TiXmlBase()			{}
 
 	/**	All TinyXml classes can print themselves to a filestream
@@ -215,14 +342,43 @@ public:
 	/**	The world does not agree on whether white space should be kept or
 		not. In order to make everyone happy, these global, static functions
 		are provided to set whether or not TinyXml will condense all white space
-		into a single space or not. The default is to condense. Note changing this
-		value is not thread safe.
+		into a single space or not. The default is to condense.
+
+		This is a plain static, read by every document as it is created: calling
+		SetCondenseWhiteSpace() while another thread creates or parses a document
+		is a data race, and is not thread safe. Set it once before any threads
+		start, or leave it alone and use TiXmlDocument::SetWhiteSpaceCondensed()
+		to set it per document instead, which is safe when documents are parsed
+		on several threads at once.
 	*/
 	static void SetCondenseWhiteSpace( bool condense )		{ condenseWhiteSpace = condense; }
 
 	/// Return the current white space setting.
 	static bool IsWhiteSpaceCondensed()						{ return condenseWhiteSpace; }
 
+	/** The parser skips over white space, text and attribute values with a
+		SIMD scanner (AVX2, SSE2 or NEON), picking the best one the CPU has on
+		first use. It is only used on a buffer the parser copied for itself, as
+		in TiXmlDocument::Parse(): in-situ parsing scans a byte at a time. ScanKernel() names the one in use. SetScanKernel() forces
+		"avx2", "sse2", "neon" or "scalar", and returns false if that one isn't
+		available here. Unlike SetCondenseWhiteSpace(), this is thread safe: a
+		parse running while the kernel is switched may scan with either one,
+		and they all find the same bytes.
+	*/
+	static const char* ScanKernel();
+	static bool SetScanKernel( const char* name );	///< See ScanKernel()
+
+	/// True if the null terminated string is well formed UTF-8.
+	static bool IsValidUTF8( const char* p );
+
+	/// Byte classes the scanner can be told to stop at. Used internally.
+	enum
+	{
+		SCAN_WHITESPACE	= 1,	// ASCII white space
+		SCAN_NON_ASCII	= 2,	// bytes over 0x7f
+		SCAN_CONTROL	= 4		// bytes under 0x20, white space included
+	};
+
 	/** Return the position, in the original source file, of this node or attribute.
 		The row and column are 1-based. (That is the first row and first column is
 		1,1). If the returns values are 0 or less, then the parser does not have
@@ -287,6 +443,14 @@ protected:
 
 	static const char* SkipWhiteSpace( const char*, TiXmlEncoding encoding );
 
+	// Fast forward over runs of bytes that need no more than copying; see
+	// tinyxmlscan.cpp. ScanWhiteSpace() returns the first byte that isn't
+	// ASCII white space. ScanText() returns the first null, '&' or 'stop',
+	// or the first byte of a kind named in flags (SCAN_*, above), but goes
+	// no further than limit if one is given.
+	static const char* ScanWhiteSpace( const char* p );
+	static const char* ScanText( const char* p, char stop, int flags, const char* limit = 0 );
+
 	inline static bool IsWhiteSpace( char c )		
 	{ 
 		return ( isspace( (unsigned char) c ) || c == '\n' || c == '\r' ); 
@@ -305,10 +469,25 @@ protected:
 
 	/*	Reads an XML name into the string provided. Returns
 		a pointer just past the last character of the name,
-		or 0 if the function has an error.
+		or 0 if the function has an error. If name is null
+		the name is only scanned over (used by in-situ parsing.)
 	*/
 	static const char* ReadName( const char* p, TIXML_STRING* name, TiXmlEncoding encoding );
 
+	/*	Given the '<' of a start tag, true if the element's name, or its
+		namespace prefix with the colon, is in the table. See
+		TiXmlDocument::SetSkipTable().
+	*/
+	static bool IsSkipped( const char* p, const TiXmlAtomTable* skipTable, TiXmlEncoding encoding );
+
+	/*	Given the '<' of a start tag, returns a pointer just past the end of
+		the element, or 0 if the input runs out first. Only the nesting of
+		the tags is followed; nothing is checked or decoded. With a depth of
+		1, p can instead be just past the start tag, to skip the content and
+		the end tag.
+	*/
+	static const char* SkipElement( const char* p, TiXmlEncoding encoding, int depth = 0 );
+
 	/*	Reads text. Returns a pointer past the given end tag.
 		Wickedly complex options, but it keeps the (sensitive) code in one place.
 	*/
@@ -317,7 +496,22 @@ protected:
 									bool ignoreWhiteSpace,		// whether to keep the white space
 									const char* endTag,			// what ends this text
 									bool ignoreCase,			// whether to ignore case in the end tag
-									TiXmlEncoding encoding );	// the current encoding
+									TiXmlEncoding encoding,		// the current encoding
+									bool validUTF8 = false );	// the input is known to be well formed UTF-8
+
+	/*	In-situ flavor of ReadText. The text is decoded in place: 'text' is set to
+		its first character and 'textEnd' to one past its last. Since entities and
+		condensed white space only ever shrink, textEnd never passes the end tag.
+		The caller decides where it is safe to write the null terminator.
+	*/
+	static char* ReadTextInSitu(	char* in,					// where to start
+									char** text,				// start of the decoded text
+									char** textEnd,				// end of the decoded text
+									bool ignoreWhiteSpace,		// whether to keep the white space
+									const char* endTag,			// what ends this text
+									bool ignoreCase,			// whether to ignore case in the end tag
+									TiXmlEncoding encoding,		// the current encoding
+									bool validUTF8 = false );	// the input is known to be well formed UTF-8
 
 	// If an entity has been found, transform it into a character.
 	static const char* GetEntity( const char* in, char* value, int* length, TiXmlEncoding encoding );
@@ -374,6 +568,31 @@ protected:
 
     /// Field containing a generic user pointer
 	void*			userData;
+
+	// Set on objects placement-constructed in a document's arena.
+	bool			inArena;
+
+	// Deletes a node or attribute, or just runs its destructor if it lives
+	// in an arena.
+	static void Destroy( TiXmlBase* base );
+
+	// Creates a T in the arena, or on the heap if there is no arena.
+	template< class T > static T* ArenaNew( TiXmlArena* arena )
+	{
+		if ( !arena )
+			return new T();
+		T* t = new ( arena->Alloc( sizeof( T ) ) ) T();
+		t->inArena = true;
+		return t;
+	}
+	template< class T > static T* ArenaNew( TiXmlArena* arena, const char* _value )
+	{
+		if ( !arena )
+			return new T( _value );
+		T* t = new ( arena->Alloc( sizeof( T ) ) ) T( _value );
+		t->inArena = true;
+		return t;
+	}
 	
 	// None of these methods are reliable for any language except English.
 	// Good for approximation, not great for accuracy.
@@ -484,17 +703,22 @@ public:
 
 		The subclasses will wrap this function.
 	*/
-	const char *Value() const { return value.c_str (); }
+	const char *Value() const { return valueInSitu ? valueInSitu : value.c_str (); }
 
     #ifdef TIXML_USE_STL
 	/** Return Value() as a std::string. If you only use STL,
 	    this is more efficient than calling Value().
 		Only available in STL mode.
+
+		Returned by value: a node parsed in-situ (see
+		TiXmlDocument::ParseInSitu()) keeps its value in the source buffer,
+		and a const read must not write the node, since several threads may
+		read one document at once. Prefer Value() where a copy matters.
 	*/
-	const std::string& ValueStr() const { return value; }
+	std::string ValueStr() const { return ValueTStr(); }
 	#endif
 
-	const TIXML_STRING& ValueTStr() const { return value; }
+	TIXML_STRING ValueTStr() const { return valueInSitu ? TIXML_STRING( valueInSitu ) : value; }
 
 	/** Changes the value of the node. Defined as:
 		@verbatim
@@ -505,11 +729,11 @@ public:
 		Text:		the text string
 		@endverbatim
 	*/
-	void SetValue(const char * _value) { value = _value;}
+	void SetValue(const char * _value) { value = _value; valueInSitu = 0; if ( inArena ) NoteHeap(); }
 
     #ifdef TIXML_USE_STL
 	/// STL std::string form.
-	void SetValue( const std::string& _value )	{ value = _value; }
+	void SetValue( const std::string& _value )	{ value = _value; valueInSitu = 0; if ( inArena ) NoteHeap(); }
 	#endif
 
 	/// Delete all the children of this node. Does not affect 'this'.
@@ -750,7 +974,12 @@ protected:
 	#endif
 
 	// Figure out what is at *p, and parse it. Returns null if it is not an xml node.
-	TiXmlNode* Identify( const char* start, TiXmlEncoding encoding );
+	TiXmlNode* Identify( const char* start, TiXmlEncoding encoding, TiXmlArena* arena = 0 );
+
+	// Tells the document that its tree now holds heap memory, so it has to
+	// be destroyed node by node. Called for edits to a node in the arena,
+	// and for heap nodes linked under one or under the document.
+	void NoteHeap();
 
 	TiXmlNode*		parent;
 	NodeType		type;
@@ -759,6 +988,7 @@ protected:
 	TiXmlNode*		lastChild;
 
 	TIXML_STRING	value;
+	const char*		valueInSitu;	// points into the source buffer when parsed in-situ, else null
 
 	TiXmlNode*		prev;
 	TiXmlNode*		next;
@@ -779,12 +1009,15 @@ private:
 class TiXmlAttribute : public TiXmlBase
 {
 	friend class TiXmlAttributeSet;
+	friend class TiXmlDeclaration;
 
 public:
 	/// Construct an empty attribute.
 	TiXmlAttribute() : TiXmlBase()
 	{
 		document = 0;
+		nameInSitu = valueInSitu = 0;
+		atom = TIXML_NO_ATOM;
 		prev = next = 0;
 	}
 
@@ -795,6 +1028,8 @@ public:
 		name = _name;
 		value = _value;
 		document = 0;
+		nameInSitu = valueInSitu = 0;
+		atom = TIXML_NO_ATOM;
 		prev = next = 0;
 	}
 	#endif
@@ -805,19 +1040,24 @@ public:
 		name = _name;
 		value = _value;
 		document = 0;
+		nameInSitu = valueInSitu = 0;
+		atom = TIXML_NO_ATOM;
 		prev = next = 0;
 	}
 
-	const char*		Name()  const		{ return name.c_str(); }		///< Return the name of this attribute.
-	const char*		Value() const		{ return value.c_str(); }		///< Return the value of this attribute.
+	const char*		Name()  const		{ return nameInSitu ? nameInSitu : name.c_str(); }		///< Return the name of this attribute.
+	const char*		Value() const		{ return valueInSitu ? valueInSitu : value.c_str(); }	///< Return the value of this attribute.
 	#ifdef TIXML_USE_STL
-	const std::string& ValueStr() const	{ return value; }				///< Return the value of this attribute.
+	std::string		ValueStr() const	{ return ValueTStr(); }			///< Return a copy of the value of this attribute.
 	#endif
+	int				Atom() const		{ return atom; }					///< Return the atom of the name (see TiXmlAtomTable), or TIXML_NO_ATOM.
 	int				IntValue() const;									///< Return the value of this attribute, converted to an integer.
 	double			DoubleValue() const;								///< Return the value of this attribute, converted to a double.
 
-	// Get the tinyxml string representation
-	const TIXML_STRING& NameTStr() const { return name; }
+	// Get the tinyxml string representation. These copy rather than cache,
+	// so reading an attribute parsed in-situ never writes to it.
+	TIXML_STRING NameTStr() const	{ return nameInSitu ? TIXML_STRING( nameInSitu ) : name; }
+	TIXML_STRING ValueTStr() const	{ return valueInSitu ? TIXML_STRING( valueInSitu ) : value; }
 
 	/** QueryIntValue examines the value string. It is an alternative to the
 		IntValue() method with richer error checking.
@@ -832,17 +1072,17 @@ public:
 	/// QueryDoubleValue examines the value string. See QueryIntValue().
 	int QueryDoubleValue( double* _value ) const;
 
-	void SetName( const char* _name )	{ name = _name; }				///< Set the name of this attribute.
-	void SetValue( const char* _value )	{ value = _value; }				///< Set the value.
+	void SetName( const char* _name )	{ name = _name; nameInSitu = 0; atom = TIXML_NO_ATOM; if ( inArena ) NoteHeap(); }		///< Set the name of this attribute.
+	void SetValue( const char* _value )	{ value = _value; valueInSitu = 0; if ( inArena ) NoteHeap(); }	///< Set the value.
 
 	void SetIntValue( int _value );										///< Set the value from an integer.
 	void SetDoubleValue( double _value );								///< Set the value from a double.
 
     #ifdef TIXML_USE_STL
 	/// STL std::string form.
-	void SetName( const std::string& _name )	{ name = _name; }	
+	void SetName( const std::string& _name )	{ name = _name; nameInSitu = 0; atom = TIXML_NO_ATOM; if ( inArena ) NoteHeap(); }	
 	/// STL std::string form.	
-	void SetValue( const std::string& _value )	{ value = _value; }
+	void SetValue( const std::string& _value )	{ value = _value; valueInSitu = 0; if ( inArena ) NoteHeap(); }
 	#endif
 
 	/// Get the next sibling attribute in the DOM. Returns null at end.
@@ -857,9 +1097,9 @@ public:
 		return const_cast< TiXmlAttribute* >( (const_cast< const TiXmlAttribute* >(this))->Previous() ); 
 	}
 
-	bool operator==( const TiXmlAttribute& rhs ) const { return rhs.name == name; }
-	bool operator<( const TiXmlAttribute& rhs )	 const { return name < rhs.name; }
-	bool operator>( const TiXmlAttribute& rhs )  const { return name > rhs.name; }
+	bool operator==( const TiXmlAttribute& rhs ) const { return strcmp( rhs.Name(), Name() ) == 0; }
+	bool operator<( const TiXmlAttribute& rhs )	 const { return strcmp( Name(), rhs.Name() ) < 0; }
+	bool operator>( const TiXmlAttribute& rhs )  const { return strcmp( Name(), rhs.Name() ) > 0; }
 
 	/*	Attribute parsing starts: first letter of the name
 						 returns: the next char after the value end quote
@@ -875,14 +1115,23 @@ public:
 	// [internal use]
 	// Set the document pointer so the attribute can report errors.
 	void SetDocument( TiXmlDocument* doc )	{ document = doc; }
+	// [internal use]
+	// Carry the atom over to a copy of this attribute.
+	void SetAtom( int _atom )				{ atom = _atom; }
 
 private:
 	TiXmlAttribute( const TiXmlAttribute& );				// not implemented.
 	void operator=( const TiXmlAttribute& base );	// not allowed.
 
+	// See TiXmlNode::NoteHeap().
+	void NoteHeap();
+
 	TiXmlDocument*	document;	// A pointer back to a document, for error reporting.
-	TIXML_STRING name;
-	TIXML_STRING value;
+	TIXML_STRING	name;
+	TIXML_STRING	value;
+	const char*		nameInSitu;		// point into the source buffer when parsed in-situ, else null
+	const char*		valueInSitu;
+	int				atom;		// see TiXmlAtomTable
 	TiXmlAttribute*	prev;
 	TiXmlAttribute*	next;
 };
@@ -915,6 +1164,7 @@ public:
 	TiXmlAttribute* Last()					{ return ( sentinel.prev == &sentinel ) ? 0 : sentinel.prev; }
 
 	TiXmlAttribute*	Find( const char* _name ) const;
+	TiXmlAttribute*	Find( int atom ) const;
 	TiXmlAttribute* FindOrCreate( const char* _name );
 
 #	ifdef TIXML_USE_STL
@@ -975,6 +1225,24 @@ public:
 	*/
 	const char* Attribute( const char* name, double* d ) const;
 
+	/** Find an attribute by its atom, see TiXmlAtomTable. Only attributes
+		read by a document with an atom table (and copies of them) have
+		atoms. Returns null if there is no such attribute.
+	*/
+	const TiXmlAttribute* FindAttribute( int atom ) const		{ return attributeSet.Find( atom ); }
+
+	/** The value of the attribute with the given atom, or null if there
+		isn't one. This is a view, not a copy: it is good for as long as
+		the attribute is left alone.
+	*/
+	const char* AttributeView( int atom ) const;
+
+	/** The atom of the element's name, from the element table of the
+		document that read it (see TiXmlDocument::SetElementTable()), or
+		TIXML_NO_ATOM. Copies keep it; SetValue() doesn't change it.
+	*/
+	int Atom() const	{ return atom; }
+
 	/** QueryIntAttribute examines the attribute - it is an alternative to the
 		Attribute() method with richer error checking.
 		If the attribute is an integer, it is stored in 'value' and 
@@ -1043,9 +1311,9 @@ public:
 	void SetAttribute( const char* name, const char * _value );
 
     #ifdef TIXML_USE_STL
-	const std::string* Attribute( const std::string& name ) const;
-	const std::string* Attribute( const std::string& name, int* i ) const;
-	const std::string* Attribute( const std::string& name, double* d ) const;
+	const char* Attribute( const std::string& name ) const;
+	const char* Attribute( const std::string& name, int* i ) const;
+	const char* Attribute( const std::string& name, double* d ) const;
 	int QueryIntAttribute( const std::string& name, int* _value ) const;
 	int QueryDoubleAttribute( const std::string& name, double* _value ) const;
 
@@ -1145,8 +1413,18 @@ protected:
 	*/
 	const char* ReadValue( const char* in, TiXmlParsingData* prevData, TiXmlEncoding encoding );
 
+	/*	[internal use]
+		Parse() in two halves. ReadStartTag() reads the name and attributes,
+		up to just past the '>', and sets 'empty' if the tag closes itself.
+		ReadContent() reads the value and the end tag.
+	*/
+	const char* ReadStartTag( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding, bool* empty );
+	const char* ReadContent( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding );
+
 private:
+	friend class TiXmlReader;
 	TiXmlAttributeSet attributeSet;
+	int atom;	// see TiXmlAtomTable
 };
 
 
@@ -1279,7 +1557,7 @@ class TiXmlDeclaration : public TiXmlNode
 {
 public:
 	/// Construct an empty declaration.
-	TiXmlDeclaration()   : TiXmlNode( TiXmlNode::TINYXML_DECLARATION ) {}
+	TiXmlDeclaration()   : TiXmlNode( TiXmlNode::TINYXML_DECLARATION ) { versionInSitu = encodingInSitu = standaloneInSitu = 0; }
 
 #ifdef TIXML_USE_STL
 	/// Constructor.
@@ -1299,11 +1577,11 @@ public:
 	virtual ~TiXmlDeclaration()	{}
 
 	/// Version. Will return an empty string if none was found.
-	const char *Version() const			{ return version.c_str (); }
+	const char *Version() const			{ return versionInSitu ? versionInSitu : version.c_str (); }
 	/// Encoding. Will return an empty string if none was found.
-	const char *Encoding() const		{ return encoding.c_str (); }
+	const char *Encoding() const		{ return encodingInSitu ? encodingInSitu : encoding.c_str (); }
 	/// Is this a standalone document?
-	const char *Standalone() const		{ return standalone.c_str (); }
+	const char *Standalone() const		{ return standaloneInSitu ? standaloneInSitu : standalone.c_str (); }
 
 	/// Creates a copy of this Declaration and returns it.
 	virtual TiXmlNode* Clone() const;
@@ -1334,6 +1612,9 @@ private:
 	TIXML_STRING version;
 	TIXML_STRING encoding;
 	TIXML_STRING standalone;
+	const char* versionInSitu;		// point into the source buffer when parsed in-situ, else null
+	const char* encodingInSitu;
+	const char* standaloneInSitu;
 };
 
 
@@ -1399,7 +1680,7 @@ public:
 	TiXmlDocument( const TiXmlDocument& copy );
 	void operator=( const TiXmlDocument& copy );
 
-	virtual ~TiXmlDocument() {}
+	virtual ~TiXmlDocument();
 
 	/** Load a file using the current document value.
 		Returns true if successful. Will delete any existing
@@ -1435,9 +1716,21 @@ public:
 	/** Parse the given null terminated block of xml data. Passing in an encoding to this
 		method (either TIXML_ENCODING_LEGACY or TIXML_ENCODING_UTF8 will force TinyXml
 		to use that encoding, regardless of what TinyXml might otherwise try to detect.
+		The data is copied into the document's arena and parsed there in-situ, so
+		the tree's strings live alongside its nodes.
 	*/
 	virtual const char* Parse( const char* p, TiXmlParsingData* data = 0, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
 
+	/** Parse the given null terminated block of xml data in-situ. Element names,
+		attribute names and values, and text are not copied: entities are decoded
+		in place and the nodes point straight into the buffer, which is modified
+		and must outlive the document. Nodes that are copied (Clone(), CopyTo())
+		own their strings again. Since nothing is known about the buffer past
+		its null, it is scanned a byte at a time, where Parse() can scan its
+		own copy with SIMD.
+	*/
+	const char* ParseInSitu( char* p, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+
 	/** Get the root element -- the only top level element -- of the document.
 		In well formed XML, there should only be one. TinyXml is tolerant of
 		multiple elements at the document level.
@@ -1498,6 +1791,37 @@ public:
 
 	int TabSize() const	{ return tabsize; }
 
+	/** Intern attribute names from the given table while parsing; see
+		TiXmlAtomTable. Like the tab size, this has to be set before the
+		parse or load. Null, the default, turns it off.
+	*/
+	void SetAtomTable( const TiXmlAtomTable* table )	{ atomTable = table; }
+	const TiXmlAtomTable* AtomTable() const				{ return atomTable; }
+
+	/** Intern element names from the given table while parsing, as
+		SetAtomTable() does for attribute names. Set before the parse or
+		load; null, the default, turns it off.
+	*/
+	void SetElementTable( const TiXmlAtomTable* table )	{ elementTable = table; }
+	const TiXmlAtomTable* ElementTable() const			{ return elementTable; }
+
+	/** Pass over some elements without reading them. An element whose name
+		is in the table, or whose namespace prefix is (given with its colon,
+		as in "sodipodi:"), is skipped along with everything inside it, and
+		no nodes are made for any of it. The root element is never skipped.
+		The table isn't copied. Set before the parse or load; null, the
+		default, turns it off.
+	*/
+	void SetSkipTable( const TiXmlAtomTable* table )	{ skipTable = table; }
+	const TiXmlAtomTable* SkipTable() const				{ return skipTable; }
+
+	/** Whether this document condenses white space when it parses. Starts
+		out as TiXmlBase::IsWhiteSpaceCondensed() was when the document was
+		created. Set before the parse or load.
+	*/
+	void SetWhiteSpaceCondensed( bool condense )	{ condenseWhiteSpaceOnParse = condense; }
+	bool WhiteSpaceCondensed() const				{ return condenseWhiteSpaceOnParse; }
+
 	/** If you have handled the error, it can be reset with this call. The error
 		state is automatically cleared if you Parse a new XML block.
 	*/
@@ -1521,6 +1845,9 @@ public:
 	virtual void Print( FILE* cfile, int depth = 0 ) const;
 	// [internal use]
 	void SetError( int err, const char* errorLocation, TiXmlParsingData* prevData, TiXmlEncoding encoding );
+	// [internal use]
+	// See TiXmlNode::NoteHeap().
+	void SetHeapInTree()	{ heapInTree = true; }
 
 	virtual const TiXmlDocument*    ToDocument()    const { return this; } ///< Cast to a more defined type. Will return null not of the requested type.
 	virtual TiXmlDocument*          ToDocument()          { return this; } ///< Cast to a more defined type. Will return null not of the requested type.
@@ -1545,6 +1872,114 @@ private:
 	int tabsize;
 	TiXmlCursor errorLocation;
 	bool useMicrosoftBOM;		// the UTF-8 BOM were found when read. Note this, and try to write.
+	bool parseInSitu;			// set for the duration of ParseInSitu()
+	TiXmlArena arena;			// parsed nodes live here; see TiXmlArena
+	bool heapInTree;			// something in the tree lives or owns memory outside the arena
+	const TiXmlAtomTable* atomTable;
+	const TiXmlAtomTable* elementTable;
+	const TiXmlAtomTable* skipTable;
+	bool condenseWhiteSpaceOnParse;
+
+	friend class TiXmlReader;
+};
+
+
+/**	Reads a document one element at a time, without building it. Next()
+	steps from tag to tag and says whether an element started or ended;
+	at a start, Element() holds the element's name and attributes, but no
+	children. Text, comments, declarations and the like are passed over.
+	Memory use depends on how deeply the elements nest, not on how big the
+	document is.
+
+	@verbatim
+	TiXmlReader reader( buffer );
+	for( ;; )
+	{
+		TiXmlReader::Event event = reader.Next();
+		if ( event == TiXmlReader::ELEMENT_START )
+			printf( "<%s>\n", reader.Element()->Value() );
+		else if ( event != TiXmlReader::ELEMENT_END )
+			break;
+	}
+	@endverbatim
+
+	Like TiXmlDocument::ParseInSitu(), the reader works in place: it writes
+	into the buffer, which must stay around while the reader is used. The
+	document is taken to be UTF-8 unless an encoding is given; its XML
+	declaration isn't looked at.
+*/
+class TiXmlReader
+{
+public:
+	enum Event
+	{
+		ELEMENT_START,	///< Element() is the new element.
+		ELEMENT_END,	///< The innermost open element has ended.
+		DOCUMENT_END,	///< The root element has ended.
+		READ_ERROR		///< See Error(). Reported from then on.
+	};
+
+	TiXmlReader( char* xml, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+	/** Reads a copy of the first length chars of xml, which needn't be null
+		terminated, rather than working in place. The copy can be scanned
+		with SIMD; a buffer read in place is scanned a byte at a time.
+	*/
+	TiXmlReader( const char* xml, size_t length, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+	~TiXmlReader();
+
+	/// Read up to the next start or end of an element.
+	Event Next();
+
+	/** The element that just started. It is reused for the next one, so
+		it, its attributes and its strings last only until the next call.
+	*/
+	const TiXmlElement* Element() const	{ return element; }
+
+	/** Call at ELEMENT_START to read the rest of the element into Element()
+		as a normal tree, which can be cloned to keep it. Its end is not
+		reported. Returns null on an error.
+	*/
+	const TiXmlElement* ReadElement();
+
+	/// Call at ELEMENT_START to pass over the rest of the element. Its end is not reported.
+	void SkipElement();
+
+	/// How many elements are open.
+	int Depth() const	{ return depth; }
+
+	/// As for TiXmlDocument. Set these before the first call to Next().
+	void SetAtomTable( const TiXmlAtomTable* table )	{ document.SetAtomTable( table ); }
+	void SetElementTable( const TiXmlAtomTable* table )	{ document.SetElementTable( table ); }	///< As for TiXmlDocument.
+	void SetSkipTable( const TiXmlAtomTable* table )	{ document.SetSkipTable( table ); }	///< As for TiXmlDocument.
+	void SetWhiteSpaceCondensed( bool condense )		{ document.SetWhiteSpaceCondensed( condense ); }	///< As for TiXmlDocument.
+	void SetTabSize( int tabsize )						{ document.SetTabSize( tabsize ); }	///< As for TiXmlDocument.
+
+	bool Error() const				{ return document.Error(); }		///< As for TiXmlDocument.
+	const char* ErrorDesc() const	{ return document.ErrorDesc(); }	///< As for TiXmlDocument.
+	int ErrorRow() const			{ return document.ErrorRow(); }		///< As for TiXmlDocument.
+	int ErrorCol() const			{ return document.ErrorCol(); }		///< As for TiXmlDocument.
+
+private:
+	TiXmlReader( const TiXmlReader& );		// not implemented.
+	void operator=( const TiXmlReader& );	// not allowed.
+
+	Event Fail( int err, const char* at );
+	void PushName();
+	void PopName();
+	size_t LastName() const;
+
+	TiXmlDocument		document;	// settings, errors and the arena
+	TiXmlArena			source;		// holds the copy, if the reader made one
+	const char*			padded;		// the copy, or null
+	size_t				paddedSize;
+	TiXmlElement*		element;	// a child of document
+	TiXmlParsingData*	data;		// made by the first Next()
+	char*				p;
+	TiXmlEncoding		encoding;
+	int					depth;
+	bool				pendingEnd;	// an empty element's end is still to come
+	bool				done;
+	TIXML_STRING		openNames;	// of the open elements, each ended by a null
 };
 
 
@@ -0,0 +1,346 @@
+/*
+ *  mkSVGColor.cpp
+ *  MonkSVG
+ *
+ *  Color parser for fill, stroke and the other paint values in svg.
+ *
+ */
+
+#include "mkSVGColor.h"
+#include "mkSVGNumber.h"
+#include <cmath>
+#include <cstring>
+
+namespace MonkSVG {
+
+namespace {
+
+struct NamedColor {
+    const char *name;
+    uint32_t    rgba;
+};
+
+// the css named colors, and transparent
+constexpr NamedColor named_colors[] = {
+    {"aliceblue", 0xf0f8ffff}, {"antiquewhite", 0xfaebd7ff},
+    {"aqua", 0x00ffffff}, {"aquamarine", 0x7fffd4ff}, {"azure", 0xf0ffffff},
+    {"beige", 0xf5f5dcff}, {"bisque", 0xffe4c4ff}, {"black", 0x000000ff},
+    {"blanchedalmond", 0xffebcdff}, {"blue", 0x0000ffff},
+    {"blueviolet", 0x8a2be2ff}, {"brown", 0xa52a2aff},
+    {"burlywood", 0xdeb887ff}, {"cadetblue", 0x5f9ea0ff},
+    {"chartreuse", 0x7fff00ff}, {"chocolate", 0xd2691eff},
+    {"coral", 0xff7f50ff}, {"cornflowerblue", 0x6495edff},
+    {"cornsilk", 0xfff8dcff}, {"crimson", 0xdc143cff}, {"cyan", 0x00ffffff},
+    {"darkblue", 0x00008bff}, {"darkcyan", 0x008b8bff},
+    {"darkgoldenrod", 0xb8860bff}, {"darkgray", 0xa9a9a9ff},
+    {"darkgreen", 0x006400ff}, {"darkgrey", 0xa9a9a9ff},
+    {"darkkhaki", 0xbdb76bff}, {"darkmagenta", 0x8b008bff},
+    {"darkolivegreen", 0x556b2fff}, {"darkorange", 0xff8c00ff},
+    {"darkorchid", 0x9932ccff}, {"darkred", 0x8b0000ff},
+    {"darksalmon", 0xe9967aff}, {"darkseagreen", 0x8fbc8fff},
+    {"darkslateblue", 0x483d8bff}, {"darkslategray", 0x2f4f4fff},
+    {"darkslategrey", 0x2f4f4fff}, {"darkturquoise", 0x00ced1ff},
+    {"darkviolet", 0x9400d3ff}, {"deeppink", 0xff1493ff},
+    {"deepskyblue", 0x00bfffff}, {"dimgray", 0x696969ff},
+    {"dimgrey", 0x696969ff}, {"dodgerblue", 0x1e90ffff},
+    {"firebrick", 0xb22222ff}, {"floralwhite", 0xfffaf0ff},
+    {"forestgreen", 0x228b22ff}, {"fuchsia", 0xff00ffff},
+    {"gainsboro", 0xdcdcdcff}, {"ghostwhite", 0xf8f8ffff},
+    {"gold", 0xffd700ff}, {"goldenrod", 0xdaa520ff}, {"gray", 0x808080ff},
+    {"green", 0x008000ff}, {"greenyellow", 0xadff2fff}, {"grey", 0x808080ff},
+    {"honeydew", 0xf0fff0ff}, {"hotpink", 0xff69b4ff},
+    {"indianred", 0xcd5c5cff}, {"indigo", 0x4b0082ff}, {"ivory", 0xfffff0ff},
+    {"khaki", 0xf0e68cff}, {"lavender", 0xe6e6faff},
+    {"lavenderblush", 0xfff0f5ff}, {"lawngreen", 0x7cfc00ff},
+    {"lemonchiffon", 0xfffacdff}, {"lightblue", 0xadd8e6ff},
+    {"lightcoral", 0xf08080ff}, {"lightcyan", 0xe0ffffff},
+    {"lightgoldenrodyellow", 0xfafad2ff}, {"lightgray", 0xd3d3d3ff},
+    {"lightgreen", 0x90ee90ff}, {"lightgrey", 0xd3d3d3ff},
+    {"lightpink", 0xffb6c1ff}, {"lightsalmon", 0xffa07aff},
+    {"lightseagreen", 0x20b2aaff}, {"lightskyblue", 0x87cefaff},
+    {"lightslategray", 0x778899ff}, {"lightslategrey", 0x778899ff},
+    {"lightsteelblue", 0xb0c4deff}, {"lightyellow", 0xffffe0ff},
+    {"lime", 0x00ff00ff}, {"limegreen", 0x32cd32ff}, {"linen", 0xfaf0e6ff},
+    {"magenta", 0xff00ffff}, {"maroon", 0x800000ff},
+    {"mediumaquamarine", 0x66cdaaff}, {"mediumblue", 0x0000cdff},
+    {"mediumorchid", 0xba55d3ff}, {"mediumpurple", 0x9370dbff},
+    {"mediumseagreen", 0x3cb371ff}, {"mediumslateblue", 0x7b68eeff},
+    {"mediumspringgreen", 0x00fa9aff}, {"mediumturquoise", 0x48d1ccff},
+    {"mediumvioletred", 0xc71585ff}, {"midnightblue", 0x191970ff},
+    {"mintcream", 0xf5fffaff}, {"mistyrose", 0xffe4e1ff},
+    {"moccasin", 0xffe4b5ff}, {"navajowhite", 0xffdeadff},
+    {"navy", 0x000080ff}, {"oldlace", 0xfdf5e6ff}, {"olive", 0x808000ff},
+    {"olivedrab", 0x6b8e23ff}, {"orange", 0xffa500ff},
+    {"orangered", 0xff4500ff}, {"orchid", 0xda70d6ff},
+    {"palegoldenrod", 0xeee8aaff}, {"palegreen", 0x98fb98ff},
+    {"paleturquoise", 0xafeeeeff}, {"palevioletred", 0xdb7093ff},
+    {"papayawhip", 0xffefd5ff}, {"peachpuff", 0xffdab9ff},
+    {"peru", 0xcd853fff}, {"pink", 0xffc0cbff}, {"plum", 0xdda0ddff},
+    {"powderblue", 0xb0e0e6ff}, {"purple", 0x800080ff},
+    {"rebeccapurple", 0x663399ff}, {"red", 0xff0000ff},
+    {"rosybrown", 0xbc8f8fff}, {"royalblue", 0x4169e1ff},
+    {"saddlebrown", 0x8b4513ff}, {"salmon", 0xfa8072ff},
+    {"sandybrown", 0xf4a460ff}, {"seagreen", 0x2e8b57ff},
+    {"seashell", 0xfff5eeff}, {"sienna", 0xa0522dff}, {"silver", 0xc0c0c0ff},
+    {"skyblue", 0x87ceebff}, {"slateblue", 0x6a5acdff},
+    {"slategray", 0x708090ff}, {"slategrey", 0x708090ff}, {"snow", 0xfffafaff},
+    {"springgreen", 0x00ff7fff}, {"steelblue", 0x4682b4ff},
+    {"tan", 0xd2b48cff}, {"teal", 0x008080ff}, {"thistle", 0xd8bfd8ff},
+    {"tomato", 0xff6347ff}, {"transparent", 0x00000000},
+    {"turquoise", 0x40e0d0ff}, {"violet", 0xee82eeff}, {"wheat", 0xf5deb3ff},
+    {"white", 0xffffffff}, {"whitesmoke", 0xf5f5f5ff}, {"yellow", 0xffff00ff},
+    {"yellowgreen", 0x9acd32ff},
+};
+
+constexpr int named_color_count =
+    int(sizeof(named_colors) / sizeof(named_colors[0]));
+
+// FNV-1a from a seed picked so each name above gets a slot of its own
+constexpr unsigned color_hash(const char *name, size_t length) {
+    unsigned hash = 55265u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return (hash ^ (hash >> 15)) & 1023;
+}
+
+constexpr size_t constexpr_strlen(const char *s) {
+    return *s ? 1 + constexpr_strlen(s + 1) : 0;
+}
+
+struct ColorTable {
+    unsigned char slots[1024]; // index into named_colors + 1, or 0
+};
+
+constexpr ColorTable make_color_table() {
+    ColorTable table = {};
+    for (int i = 0; i < named_color_count; i++) {
+        const char *name = named_colors[i].name;
+        unsigned    slot = color_hash(name, constexpr_strlen(name));
+        // two names in one slot: pick another seed
+        if (table.slots[slot] != 0)
+            throw "color_hash is not perfect";
+        table.slots[slot] = (unsigned char)(i + 1);
+    }
+    return table;
+}
+
+constexpr ColorTable color_table = make_color_table();
+
+// hex digit values, and 0x10 for anything else
+struct HexTable {
+    unsigned char values[256];
+};
+
+constexpr HexTable make_hex_table() {
+    HexTable table = {};
+    for (int i = 0; i < 256; i++) {
+        table.values[i] = 0x10;
+    }
+    for (int i = 0; i < 10; i++) {
+        table.values['0' + i] = (unsigned char)i;
+    }
+    for (int i = 0; i < 6; i++) {
+        table.values['a' + i] = table.values['A' + i] = (unsigned char)(10 + i);
+    }
+    return table;
+}
+
+constexpr HexTable hex_table = make_hex_table();
+
+inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+inline char lower(char c) { return c >= 'A' && c <= 'Z' ? c + 32 : c; }
+
+// the digits are all read, and checked once at the end
+bool read_hex(const char *s, size_t length, uint32_t *rgba) {
+    unsigned digits[8];
+    unsigned invalid = 0;
+    for (size_t i = 0; i < length; i++) {
+        digits[i] = hex_table.values[(unsigned char)s[i]];
+        invalid |= digits[i];
+    }
+    if (invalid & 0x10) {
+        return false;
+    }
+
+    uint32_t color = 0;
+    if (length == 3 || length == 4) {
+        // each digit doubled: #abc is #aabbcc
+        for (size_t i = 0; i < length; i++) {
+            color = color << 8 | digits[i] * 0x11;
+        }
+    } else {
+        for (size_t i = 0; i < length; i++) {
+            color = color << 4 | digits[i];
+        }
+    }
+    // no alpha given is opaque
+    *rgba = length == 3 || length == 6 ? color << 8 | 0xff : color;
+    return true;
+}
+
+inline unsigned to_byte(float v) {
+    v = v < 0 ? 0 : v > 1 ? 1 : v;
+    return unsigned(v * 255.0f + 0.5f);
+}
+
+float hue_to_rgb(float m1, float m2, float h) {
+    h = h < 0 ? h + 1 : h > 1 ? h - 1 : h;
+    if (h * 6 < 1)
+        return m1 + (m2 - m1) * h * 6;
+    if (h * 2 < 1)
+        return m2;
+    if (h * 3 < 2)
+        return m1 + (m2 - m1) * (2.0f / 3 - h) * 6;
+    return m1;
+}
+
+// the arguments of rgb() or hsl(), from after the '(' to end: three or
+// four numbers, each maybe a percentage or (the hue) in degrees, separated
+// by space or a single ','. each separator must have a number after it
+bool read_color_function(const char *c, const char *end, bool hsl,
+                         uint32_t *rgba) {
+    float args[4] = {0, 0, 0, 1};
+    bool  percent[4] = {false, false, false, false};
+    int   count = 0;
+    for (;;) {
+        while (c < end && is_space(*c)) {
+            c++;
+        }
+        if (c < end && *c == ')') {
+            break;
+        }
+        // the alpha may follow a '/' instead
+        if (count > 0 && c < end && (*c == ',' || (count == 3 && *c == '/'))) {
+            c++;
+            while (c < end && is_space(*c)) {
+                c++;
+            }
+        }
+        // svg_read_number would skip another ',' itself
+        if (count == 4 || (c < end && (*c == ',' || *c == '/'))) {
+            return false;
+        }
+        const char *next = svg_read_number(c, &args[count]);
+        if (next == c || next > end) {
+            return false;
+        }
+        c = next;
+        if (c < end && *c == '%') {
+            percent[count] = true;
+            c++;
+        } else if (hsl && count == 0 && end - c >= 3 &&
+                   strncmp(c, "deg", 3) == 0) {
+            c += 3;
+        }
+        count++;
+    }
+    // the ')' must end the color
+    for (c++; c < end && is_space(*c); c++) {
+    }
+    if (count < 3 || c != end) {
+        return false;
+    }
+
+    float alpha = percent[3] ? args[3] / 100 : args[3];
+    float r, g, b;
+    if (hsl) {
+        float h = fmodf(args[0], 360) / 360;
+        h = h < 0 ? h + 1 : h;
+        float s = args[1] / 100, l = args[2] / 100;
+        s = s < 0 ? 0 : s > 1 ? 1 : s;
+        l = l < 0 ? 0 : l > 1 ? 1 : l;
+        float m2 = l <= 0.5f ? l * (s + 1) : l + s - l * s;
+        float m1 = l * 2 - m2;
+        r = hue_to_rgb(m1, m2, h + 1.0f / 3);
+        g = hue_to_rgb(m1, m2, h);
+        b = hue_to_rgb(m1, m2, h - 1.0f / 3);
+    } else {
+        r = percent[0] ? args[0] / 100 : args[0] / 255;
+        g = percent[1] ? args[1] / 100 : args[1] / 255;
+        b = percent[2] ? args[2] / 100 : args[2] / 255;
+    }
+    *rgba = to_byte(r) << 24 | to_byte(g) << 16 | to_byte(b) << 8 |
+            to_byte(alpha);
+    return true;
+}
+
+} // namespace
+
+SVGColorKind svg_read_color(const char *s, size_t length, uint32_t *rgba) {
+    const char *end = s + length;
+    while (s < end && is_space(*s)) {
+        s++;
+    }
+    while (end > s && is_space(end[-1])) {
+        end--;
+    }
+    length = size_t(end - s);
+
+    if (length > 0 && *s == '#') {
+        if (length == 4 || length == 5 || length == 7 || length == 9) {
+            return read_hex(s + 1, length - 1, rgba) ? SVG_COLOR_RGBA
+                                                     : SVG_COLOR_INVALID;
+        }
+        return SVG_COLOR_INVALID;
+    }
+
+    // keywords and function names, lower cased. the longest name is 20
+    // letters
+    char   name[24];
+    size_t name_length = 0;
+    for (; name_length < length && name_length < sizeof(name) &&
+           s[name_length] != '(' && !is_space(s[name_length]);
+         name_length++) {
+        name[name_length] = lower(s[name_length]);
+    }
+    if (name_length == sizeof(name)) {
+        return SVG_COLOR_INVALID;
+    }
+
+    if (name_length < length) {
+        const char *open = s + name_length;
+        while (open < end && is_space(*open)) {
+            open++;
+        }
+        if (open == end || *open != '(') {
+            return SVG_COLOR_INVALID;
+        }
+        bool hsl;
+        if ((name_length == 3 || (name_length == 4 && name[3] == 'a')) &&
+            memcmp(name, "rgb", 3) == 0) {
+            hsl = false;
+        } else if ((name_length == 3 || (name_length == 4 && name[3] == 'a')) &&
+                   memcmp(name, "hsl", 3) == 0) {
+            hsl = true;
+        } else {
+            return SVG_COLOR_INVALID;
+        }
+        return read_color_function(open + 1, end, hsl, rgba)
+                   ? SVG_COLOR_RGBA
+                   : SVG_COLOR_INVALID;
+    }
+
+    if (name_length == 4 && memcmp(name, "none", 4) == 0) {
+        return SVG_COLOR_NONE;
+    }
+    if (name_length == 12 && memcmp(name, "currentcolor", 12) == 0) {
+        return SVG_COLOR_CURRENT;
+    }
+    int slot = color_table.slots[color_hash(name, name_length)];
+    if (slot == 0) {
+        return SVG_COLOR_INVALID;
+    }
+    const NamedColor &color = named_colors[slot - 1];
+    if (strncmp(color.name, name, name_length) != 0 ||
+        color.name[name_length] != 0) {
+        return SVG_COLOR_INVALID;
+    }
+    *rgba = color.rgba;
+    return SVG_COLOR_RGBA;
+}
+
+} // namespace MonkSVG
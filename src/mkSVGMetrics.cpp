@@ -0,0 +1,76 @@
+/*
+ *  mkSVGMetrics.cpp
+ *  MonkSVG
+ *
+ *  The bounds and counts of an svg, found without building anything.
+ *
+ */
+
+#include "mkSVGMetrics.h"
+#include "mkSVGParserT.h"
+#include "mkSVGPath.h"
+
+namespace MonkSVG {
+
+SVG_MetricsHandler::SVG_MetricsHandler() {
+    _metrics.min_x = _metrics.min_y = MAXFLOAT;
+    _metrics.max_x = _metrics.max_y = -MAXFLOAT;
+    _metrics.paths = 0;
+    _metrics.segments = 0;
+    _metrics.groups = 0;
+    _metrics.uses = 0;
+}
+
+void SVG_MetricsHandler::push(const SVGAttributes &attributes) {
+    if (attributes.set & SVGAttributes::TRANSFORM) {
+        Transform2d product;
+        Transform2d::multiply(product, transform(), attributes.transform);
+        _transforms.push_back(product);
+    } else {
+        _transforms.push_back(transform());
+    }
+}
+
+void SVG_MetricsHandler::onGroup(const SVGAttributes &attributes) {
+    _metrics.groups++;
+    push(attributes);
+}
+
+void SVG_MetricsHandler::onGroupEnd() { _transforms.pop_back(); }
+
+void SVG_MetricsHandler::onUse(const SVGAttributes &attributes) {
+    _metrics.uses++;
+    push(attributes);
+}
+
+void SVG_MetricsHandler::onUseEnd() { _transforms.pop_back(); }
+
+void SVG_MetricsHandler::onPath(const SVGPath &path) {
+    Transform2d path_transform = transform();
+    if (path.attributes.set & SVGAttributes::TRANSFORM) {
+        Transform2d::multiply(path_transform, transform(),
+                              path.attributes.transform);
+    }
+    float bounds[4] = {_metrics.min_x, _metrics.min_y, _metrics.max_x,
+                       _metrics.max_y};
+    svg_path_bounds(path.commands, path.command_count, path.coordinates,
+                    path_transform, bounds);
+    _metrics.min_x = bounds[0];
+    _metrics.min_y = bounds[1];
+    _metrics.max_x = bounds[2];
+    _metrics.max_y = bounds[3];
+
+    _metrics.paths++;
+    _metrics.segments += path.command_count;
+}
+
+bool svg_measure(const std::string &svg, SVGMetrics *metrics) {
+    auto handler = std::make_shared<SVG_MetricsHandler>();
+    SVG_ParserT<SVG_MetricsHandler> parser(handler);
+    parser.setAttributeMask(SVGAttributes::TRANSFORM);
+    bool parsed = parser.parse(svg);
+    *metrics = handler->metrics();
+    return parsed;
+}
+
+} // namespace MonkSVG
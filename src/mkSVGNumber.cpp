@@ -0,0 +1,138 @@
+/*
+ *  mkSVGNumber.cpp
+ *  MonkSVG
+ *
+ *  Number lexer for path data and the other number lists in svg attributes.
+ *
+ */
+
+#include "mkSVGNumber.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#if __cplusplus >= 201703L
+#include <charconv>
+#endif
+#if !defined(__cpp_lib_to_chars)
+#include <locale.h>
+#if defined(__APPLE__)
+#include <xlocale.h>
+#endif
+#endif
+
+namespace MonkSVG {
+
+static inline bool is_separator(char c) {
+    return c == ' ' || c == ',' || c == '\t' || c == '\n' || c == '\r' ||
+           c == '\v' || c == '\f';
+}
+
+static inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+#if !defined(__cpp_lib_to_chars)
+// strtof() in the "C" locale, whatever the current one is: plain strtof()
+// would stop at the '.' under a locale with a decimal comma. the locale is
+// made once and kept
+static float strtof_c(const char *s) {
+#if defined(_MSC_VER)
+    static const _locale_t c_locale = _create_locale(LC_ALL, "C");
+    return _strtof_l(s, 0, c_locale);
+#else
+    static const locale_t c_locale = newlocale(LC_ALL_MASK, "C", locale_t(0));
+    return strtof_l(s, 0, c_locale);
+#endif
+}
+#endif
+
+const char *svg_read_number(const char *s, float *value) {
+    while (is_separator(*s)) {
+        s++;
+    }
+
+    // one pass over the grammar finds the end and, for the short numbers
+    // that make up nearly all svg data, the digits as an integer
+    const char *p = s;
+    bool        negative = false;
+    if (*p == '+' || *p == '-') {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int      digits = 0;   // significant digits in mantissa
+    int      exponent = 0; // the value is mantissa * 10^exponent
+    bool     any = false;
+    for (; is_digit(*p); p++) {
+        any = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        } else {
+            exponent++;
+        }
+    }
+    if (*p == '.') {
+        p++;
+        for (; is_digit(*p); p++) {
+            any = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+    if (!any) {
+        *value = 0;
+        return s;
+    }
+
+    // an exponent needs at least one digit, or the 'e' isn't part of it
+    if (*p == 'e' || *p == 'E') {
+        const char *e = p + 1;
+        bool        exponent_negative = false;
+        if (*e == '+' || *e == '-') {
+            exponent_negative = *e == '-';
+            e++;
+        }
+        if (is_digit(*e)) {
+            int explicit_exponent = 0;
+            for (; is_digit(*e); e++) {
+                if (explicit_exponent < 100000) {
+                    explicit_exponent = explicit_exponent * 10 + (*e - '0');
+                }
+            }
+            exponent += exponent_negative ? -explicit_exponent
+                                          : explicit_exponent;
+            p = e;
+        }
+    }
+
+    // both the mantissa and the power of ten are exact floats, so a single
+    // multiply or divide rounds the same way strtof() does
+    static const float powers_of_ten[] = {1e0f, 1e1f, 1e2f, 1e3f,
+                                          1e4f, 1e5f, 1e6f, 1e7f,
+                                          1e8f, 1e9f, 1e10f};
+    if (mantissa <= (uint64_t(1) << 24) && exponent >= -10 && exponent <= 10) {
+        float f = float(mantissa);
+        f = exponent < 0 ? f / powers_of_ten[-exponent]
+                         : f * powers_of_ten[exponent];
+        *value = negative ? -f : f;
+        return p;
+    }
+
+#if defined(__cpp_lib_to_chars)
+    float f;
+    const char *digits_start = *s == '+' || *s == '-' ? s + 1 : s;
+    if (std::from_chars(digits_start, p, f).ec != std::errc()) {
+        // out of range: strtof() gives infinity or zero for these
+        f = exponent > 0 ? HUGE_VALF : 0.0f;
+    }
+    *value = negative ? -f : f;
+#else
+    *value = strtof_c(s);
+#endif
+    return p;
+}
+
+} // namespace MonkSVG
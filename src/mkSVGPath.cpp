@@ -0,0 +1,479 @@
+/*
+ *  mkSVGPath.cpp
+ *  MonkSVG
+ *
+ *  Path data normalized to absolute, fully spelled out segments, and the
+ *  bounds of paths in that form.
+ *
+ */
+
+#include "mkSVGPath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace MonkSVG {
+
+namespace {
+
+// where the output goes
+struct PathWriter {
+    std::vector<unsigned char> *commands;
+    std::vector<float>         *coordinates;
+
+    void segment(unsigned char command, const float *values) {
+        commands->push_back(command);
+        coordinates->insert(coordinates->end(), values,
+                            values + svg_path_coordinates(command));
+    }
+
+    void line(float x, float y) {
+        float values[] = {x, y};
+        segment(SVG_PATH_LINE_TO, values);
+    }
+};
+
+const double pi = 3.14159265358979323846;
+
+// an arc by its center: the point at angle t on it is
+// (cx + a cos_phi cos t - b sin_phi sin t, cy + a sin_phi cos t + b cos_phi sin t)
+// for t from theta to theta + sweep
+struct CenterArc {
+    double cx, cy, a, b, cos_phi, sin_phi, theta, sweep;
+};
+
+// the center form of the arc from (x0, y0) to (x, y), as in the
+// implementation notes of the svg spec (F.6.5, F.6.6). the arc must have
+// two radii and two ends
+CenterArc center_arc(float x0, float y0, float rx, float ry,
+                     float x_axis_rotation, bool large_arc, bool sweep,
+                     float x, float y) {
+    double a = std::fabs(double(rx)), b = std::fabs(double(ry));
+    double phi = x_axis_rotation * pi / 180.0;
+    double cos_phi = std::cos(phi), sin_phi = std::sin(phi);
+
+    // the start point, in the ellipse's frame, about the chord's middle
+    double dx = (x0 - x) / 2.0, dy = (y0 - y) / 2.0;
+    double x1 = cos_phi * dx + sin_phi * dy;
+    double y1 = -sin_phi * dx + cos_phi * dy;
+
+    // radii too small to reach are scaled up until they just do
+    double lambda = (x1 * x1) / (a * a) + (y1 * y1) / (b * b);
+    if (lambda > 1) {
+        a *= std::sqrt(lambda);
+        b *= std::sqrt(lambda);
+    }
+
+    double numerator = a * a * b * b - a * a * y1 * y1 - b * b * x1 * x1;
+    double denominator = a * a * y1 * y1 + b * b * x1 * x1;
+    double coefficient =
+        std::sqrt(std::max(0.0, numerator / denominator));
+    if (large_arc == sweep) {
+        coefficient = -coefficient;
+    }
+    double cx1 = coefficient * a * y1 / b;
+    double cy1 = -coefficient * b * x1 / a;
+    double cx = cos_phi * cx1 - sin_phi * cy1 + (x0 + x) / 2.0;
+    double cy = sin_phi * cx1 + cos_phi * cy1 + (y0 + y) / 2.0;
+
+    double theta = std::atan2((y1 - cy1) / b, (x1 - cx1) / a);
+    double end = std::atan2((-y1 - cy1) / b, (-x1 - cx1) / a);
+    double sweep_angle = end - theta;
+    if (!sweep && sweep_angle > 0) {
+        sweep_angle -= 2 * pi;
+    } else if (sweep && sweep_angle < 0) {
+        sweep_angle += 2 * pi;
+    }
+
+    CenterArc arc = {cx, cy, a, b, cos_phi, sin_phi, theta, sweep_angle};
+    return arc;
+}
+
+// the arc from (x0, y0) to (x, y) as cubics
+template <typename Writer>
+void arc_to_cubics(Writer *out, float x0, float y0, float rx, float ry,
+                   float x_axis_rotation, bool large_arc, bool sweep, float x,
+                   float y) {
+    if (x0 == x && y0 == y) {
+        return;
+    }
+    if (rx == 0 || ry == 0) {
+        out->line(x, y);
+        return;
+    }
+
+    const CenterArc arc = center_arc(x0, y0, rx, ry, x_axis_rotation,
+                                     large_arc, sweep, x, y);
+    int    segments = int(std::ceil(std::fabs(arc.sweep) / (pi / 2) - 1e-9));
+    double delta = arc.sweep / segments;
+    double k = 4.0 / 3.0 * std::tan(delta / 4);
+    // a point given on the unit circle, on the ellipse
+    auto map = [&](double ux, double uy, float *point) {
+        point[0] = float(arc.cx + arc.a * arc.cos_phi * ux -
+                         arc.b * arc.sin_phi * uy);
+        point[1] = float(arc.cy + arc.a * arc.sin_phi * ux +
+                         arc.b * arc.cos_phi * uy);
+    };
+    for (int i = 0; i < segments; i++) {
+        double t1 = arc.theta + i * delta, t2 = t1 + delta;
+        double c1 = std::cos(t1), s1 = std::sin(t1);
+        double c2 = std::cos(t2), s2 = std::sin(t2);
+        float  values[6];
+        map(c1 - k * s1, s1 + k * c1, &values[0]);
+        map(c2 + k * s2, s2 - k * c2, &values[2]);
+        map(c2, s2, &values[4]);
+        if (i == segments - 1) {
+            // land exactly on the end point
+            values[4] = x;
+            values[5] = y;
+        }
+        out->segment(SVG_PATH_CUBIC, values);
+    }
+}
+
+// the path's segments as svg_normalize_path gives them, each passed to
+// out->segment() as it is worked out
+template <typename Writer>
+void write_normalized(const unsigned char *commands, size_t command_count,
+                      const float *coordinates, bool arcs_to_cubics,
+                      Writer *out) {
+    float x = 0, y = 0;             // the pen
+    float start_x = 0, start_y = 0; // where the subpath started
+    // the last segment's last control point, which S and T reflect if it
+    // was a cubic or a quad
+    float control_x = 0, control_y = 0;
+    int   previous = SVG_PATH_MOVE_TO;
+
+    const float *c = coordinates;
+    for (size_t i = 0; i < command_count; i++) {
+        unsigned char command = commands[i];
+        int           type = command & SVG_PATH_COMMAND_MASK;
+        float         dx = 0, dy = 0; // what relative coordinates are from
+        if (command & SVG_PATH_RELATIVE) {
+            dx = x;
+            dy = y;
+        }
+
+        float values[6];
+        switch (type) {
+        case SVG_PATH_CLOSE:
+            out->segment(SVG_PATH_CLOSE, values);
+            x = start_x;
+            y = start_y;
+            break;
+        case SVG_PATH_MOVE_TO:
+            x = start_x = c[0] + dx;
+            y = start_y = c[1] + dy;
+            values[0] = x;
+            values[1] = y;
+            out->segment(SVG_PATH_MOVE_TO, values);
+            break;
+        case SVG_PATH_LINE_TO:
+            x = c[0] + dx;
+            y = c[1] + dy;
+            out->line(x, y);
+            break;
+        case SVG_PATH_HORIZONTAL_LINE:
+            x = c[0] + dx;
+            out->line(x, y);
+            break;
+        case SVG_PATH_VERTICAL_LINE:
+            y = c[0] + dy;
+            out->line(x, y);
+            break;
+        case SVG_PATH_CUBIC:
+        case SVG_PATH_SCUBIC: {
+            const float *rest = c; // the second control point and the end
+            if (type == SVG_PATH_CUBIC) {
+                values[0] = c[0] + dx;
+                values[1] = c[1] + dy;
+                rest = c + 2;
+            } else if (previous == SVG_PATH_CUBIC ||
+                       previous == SVG_PATH_SCUBIC) {
+                values[0] = 2 * x - control_x;
+                values[1] = 2 * y - control_y;
+            } else {
+                values[0] = x;
+                values[1] = y;
+            }
+            values[2] = control_x = rest[0] + dx;
+            values[3] = control_y = rest[1] + dy;
+            values[4] = x = rest[2] + dx;
+            values[5] = y = rest[3] + dy;
+            out->segment(SVG_PATH_CUBIC, values);
+            break;
+        }
+        case SVG_PATH_QUAD:
+        case SVG_PATH_SQUAD: {
+            const float *rest = c; // the end
+            if (type == SVG_PATH_QUAD) {
+                control_x = c[0] + dx;
+                control_y = c[1] + dy;
+                rest = c + 2;
+            } else if (previous == SVG_PATH_QUAD ||
+                       previous == SVG_PATH_SQUAD) {
+                control_x = 2 * x - control_x;
+                control_y = 2 * y - control_y;
+            } else {
+                control_x = x;
+                control_y = y;
+            }
+            values[0] = control_x;
+            values[1] = control_y;
+            values[2] = x = rest[0] + dx;
+            values[3] = y = rest[1] + dy;
+            out->segment(SVG_PATH_QUAD, values);
+            break;
+        }
+        case SVG_PATH_ARC: {
+            float end_x = c[3] + dx, end_y = c[4] + dy;
+            if (arcs_to_cubics) {
+                arc_to_cubics(out, x, y, c[0], c[1], c[2],
+                              (command & SVG_PATH_ARC_LARGE) != 0,
+                              (command & SVG_PATH_ARC_SWEEP) != 0, end_x,
+                              end_y);
+            } else {
+                values[0] = c[0];
+                values[1] = c[1];
+                values[2] = c[2];
+                values[3] = end_x;
+                values[4] = end_y;
+                out->segment(command & ~SVG_PATH_RELATIVE, values);
+            }
+            x = end_x;
+            y = end_y;
+            break;
+        }
+        case SVG_PATH_RECT:
+            if (c[2] > 0 && c[3] > 0) {
+                values[0] = c[0];
+                values[1] = c[1];
+                out->segment(SVG_PATH_MOVE_TO, values);
+                out->line(c[0] + c[2], c[1]);
+                out->line(c[0] + c[2], c[1] + c[3]);
+                out->line(c[0], c[1] + c[3]);
+                out->segment(SVG_PATH_CLOSE, values);
+                x = start_x = c[0];
+                y = start_y = c[1];
+            }
+            break;
+        }
+        previous = type;
+        c += svg_path_coordinates(command);
+    }
+}
+
+// the t in (0, 1) where a t^2 + b t + c is zero, into t. returns how many
+int unit_roots(double a, double b, double c, double t[2]) {
+    int  count = 0;
+    auto keep = [&](double root) {
+        if (root > 0 && root < 1) {
+            t[count++] = root;
+        }
+    };
+    if (a == 0) {
+        if (b != 0) {
+            keep(-c / b);
+        }
+        return count;
+    }
+    double discriminant = b * b - 4 * a * c;
+    if (discriminant < 0) {
+        return count;
+    }
+    // the form that doesn't cancel when a is small
+    double q = -0.5 * (b + std::copysign(std::sqrt(discriminant), b));
+    if (q != 0) {
+        keep(q / a);
+        keep(c / q);
+    }
+    return count;
+}
+
+// a box grown by segments, already normalized, mapped through a transform.
+// a curve is only solved for where it turns if a control point is outside
+// the box: it lies within its control points, so otherwise it can't grow it
+struct BoundsWriter {
+    const Transform2d &m;
+    float             *box;    // min x, min y, max x, max y
+    float              x, y;   // the pen
+    double             mx, my; // and mapped
+    float              start_x, start_y;
+    bool               moved; // the pen isn't in the box yet
+
+    double map_x(double x_, double y_) const {
+        return m.a * x_ + m.c * y_ + m.e;
+    }
+    double map_y(double x_, double y_) const {
+        return m.b * x_ + m.d * y_ + m.f;
+    }
+
+    // a point already mapped
+    void add(double px, double py) {
+        box[0] = std::min(box[0], float(px));
+        box[1] = std::min(box[1], float(py));
+        box[2] = std::max(box[2], float(px));
+        box[3] = std::max(box[3], float(py));
+    }
+
+    bool inside(double px, double py) const {
+        return float(px) >= box[0] && float(px) <= box[2] &&
+               float(py) >= box[1] && float(py) <= box[3];
+    }
+
+    // starts a segment from the pen, and ends it at (x_, y_)
+    void draw_to(float x_, float y_) {
+        if (moved) {
+            add(mx, my);
+            moved = false;
+        }
+        x = x_;
+        y = y_;
+        mx = map_x(x, y);
+        my = map_y(x, y);
+        add(mx, my);
+    }
+
+    void line(float x_, float y_) { draw_to(x_, y_); }
+
+    void segment(unsigned char command, const float *c) {
+        switch (command & SVG_PATH_COMMAND_MASK) {
+        case SVG_PATH_CLOSE:
+            draw_to(start_x, start_y);
+            break;
+        case SVG_PATH_MOVE_TO:
+            // a point is only drawn by a segment from it
+            x = start_x = c[0];
+            y = start_y = c[1];
+            mx = map_x(x, y);
+            my = map_y(x, y);
+            moved = true;
+            break;
+        case SVG_PATH_LINE_TO:
+            draw_to(c[0], c[1]);
+            break;
+        case SVG_PATH_CUBIC: {
+            double p[8] = {mx,
+                           my,
+                           map_x(c[0], c[1]),
+                           map_y(c[0], c[1]),
+                           map_x(c[2], c[3]),
+                           map_y(c[2], c[3]),
+                           0,
+                           0};
+            draw_to(c[4], c[5]);
+            p[6] = mx;
+            p[7] = my;
+            if (!inside(p[2], p[3]) || !inside(p[4], p[5])) {
+                cubic_bounds(p);
+            }
+            break;
+        }
+        case SVG_PATH_QUAD: {
+            double p[6] = {
+                mx, my, map_x(c[0], c[1]), map_y(c[0], c[1]), 0, 0};
+            draw_to(c[2], c[3]);
+            p[4] = mx;
+            p[5] = my;
+            if (!inside(p[2], p[3])) {
+                quad_bounds(p);
+            }
+            break;
+        }
+        case SVG_PATH_ARC: {
+            float x0 = x, y0 = y;
+            draw_to(c[3], c[4]);
+            arc_bounds(x0, y0, c, command);
+            break;
+        }
+        }
+    }
+
+    // a cubic's extremes, on each axis, between its ends. p is the mapped
+    // control points, x y for each
+    void cubic_bounds(const double p[8]) {
+        for (int axis = 0; axis < 2; axis++) {
+            const double *q = p + axis;
+            double        t[2];
+            int count = unit_roots(-q[0] + 3 * q[2] - 3 * q[4] + q[6],
+                                   2 * (q[0] - 2 * q[2] + q[4]), q[2] - q[0],
+                                   t);
+            for (int i = 0; i < count; i++) {
+                double u = 1 - t[i];
+                double w[4] = {u * u * u, 3 * u * u * t[i],
+                               3 * u * t[i] * t[i], t[i] * t[i] * t[i]};
+                add(w[0] * p[0] + w[1] * p[2] + w[2] * p[4] + w[3] * p[6],
+                    w[0] * p[1] + w[1] * p[3] + w[2] * p[5] + w[3] * p[7]);
+            }
+        }
+    }
+
+    // the same for a quad, with three control points
+    void quad_bounds(const double p[6]) {
+        for (int axis = 0; axis < 2; axis++) {
+            const double *q = p + axis;
+            double        t[2];
+            int count = unit_roots(0, q[0] - 2 * q[2] + q[4], q[2] - q[0], t);
+            for (int i = 0; i < count; i++) {
+                double u = 1 - t[i];
+                double w[3] = {u * u, 2 * u * t[i], t[i] * t[i]};
+                add(w[0] * p[0] + w[1] * p[2] + w[2] * p[4],
+                    w[0] * p[1] + w[1] * p[3] + w[2] * p[5]);
+            }
+        }
+    }
+
+    // an arc's extremes between its ends. mapped, the ellipse is still
+    // c + u cos t + v sin t, and each coordinate of that is at its least
+    // and most where tan t = v / u on that axis
+    void arc_bounds(float x0, float y0, const float *c,
+                    unsigned char command) {
+        if ((x0 == c[3] && y0 == c[4]) || c[0] == 0 || c[1] == 0) {
+            return; // nothing, or a line: the ends are all there is
+        }
+        const CenterArc arc = center_arc(
+            x0, y0, c[0], c[1], c[2], (command & SVG_PATH_ARC_LARGE) != 0,
+            (command & SVG_PATH_ARC_SWEEP) != 0, c[3], c[4]);
+        double ux = arc.a * arc.cos_phi, uy = arc.a * arc.sin_phi;
+        double vx = -arc.b * arc.sin_phi, vy = arc.b * arc.cos_phi;
+        double center[2] = {map_x(arc.cx, arc.cy), map_y(arc.cx, arc.cy)};
+        double u[2] = {m.a * ux + m.c * uy, m.b * ux + m.d * uy};
+        double v[2] = {m.a * vx + m.c * vy, m.b * vx + m.d * vy};
+        for (int axis = 0; axis < 2; axis++) {
+            double extreme = std::atan2(v[axis], u[axis]);
+            for (int half = 0; half < 2; half++) {
+                double t = extreme + half * pi;
+                // how far round from the start, the way the arc goes
+                double along = std::fmod(
+                    arc.sweep >= 0 ? t - arc.theta : arc.theta - t, 2 * pi);
+                if (along < 0) {
+                    along += 2 * pi;
+                }
+                if (along <= std::fabs(arc.sweep)) {
+                    double cos_t = std::cos(t), sin_t = std::sin(t);
+                    add(center[0] + u[0] * cos_t + v[0] * sin_t,
+                        center[1] + u[1] * cos_t + v[1] * sin_t);
+                }
+            }
+        }
+    }
+};
+
+} // namespace
+
+void svg_normalize_path(const unsigned char *commands, size_t command_count,
+                        const float *coordinates, bool arcs_to_cubics,
+                        std::vector<unsigned char> *commands_out,
+                        std::vector<float>         *coordinates_out) {
+    PathWriter out = {commands_out, coordinates_out};
+    write_normalized(commands, command_count, coordinates, arcs_to_cubics,
+                     &out);
+}
+
+void svg_path_bounds(const unsigned char *commands, size_t command_count,
+                     const float *coordinates, const Transform2d &transform,
+                     float bounds[4]) {
+    BoundsWriter out = {transform, bounds, 0, 0, 0, 0, 0, 0, false};
+    write_normalized(commands, command_count, coordinates, false, &out);
+}
+
+} // namespace MonkSVG
@@ -0,0 +1,88 @@
+/*
+ *  mkSVGTape.cpp
+ *  MonkSVG
+ *
+ *  Handler calls recorded once, to be played back as many times as needed.
+ *
+ */
+
+#include "mkSVGTape.h"
+
+namespace MonkSVG {
+
+SVG_TapeRecorder::SVG_TapeRecorder(SVG_Tape *tape) : _tape(tape), _depth(0) {
+    setRelative(false);
+}
+
+uint32_t SVG_TapeRecorder::attributes(const SVGAttributes &attributes) {
+    _tape->_depth = std::max(_tape->_depth, _depth);
+    uint32_t index = uint32_t(_tape->_attributes.size());
+    _tape->_attributes.push_back(attributes);
+    _tape->_attributes.back().id.data = 0;
+    if (attributes.set & SVGAttributes::ID) {
+        _tape->_ids.push_back(uint32_t(_tape->_strings.size()));
+        _tape->_strings.push_back(attributes.id.str());
+    } else {
+        _tape->_ids.push_back(0);
+    }
+    return index;
+}
+
+// the end is filled in by the matching end(); one that never comes, as
+// after a read error, is past the end of the tape
+void SVG_TapeRecorder::begin(SVG_Tape::Op op,
+                             const SVGAttributes &attributes) {
+    uint32_t index = this->attributes(attributes);
+    _tape->_words.push_back(op);
+    _tape->_words.push_back(_depth);
+    _open.push_back(_tape->_words.size());
+    _tape->_words.push_back(uint32_t(-1));
+    _tape->_words.push_back(index);
+}
+
+// an end without a begin, for an element that was open when recording
+// started, is recorded as it is
+void SVG_TapeRecorder::end(SVG_Tape::Op op) {
+    _tape->_words.push_back(op);
+    if (!_open.empty()) {
+        _tape->_words[_open.back()] = uint32_t(_tape->_words.size());
+        _open.pop_back();
+    }
+}
+
+void SVG_TapeRecorder::onInstance(uint32_t slot) {
+    _tape->_words.push_back(SVG_Tape::OP_INSTANCE);
+    _tape->_words.push_back(slot);
+    _tape->_words.push_back(_depth);
+    _tape->_instances.push_back(slot);
+}
+
+void SVG_TapeRecorder::onGroup(const SVGAttributes &attributes) {
+    begin(SVG_Tape::OP_GROUP_BEGIN, attributes);
+}
+
+void SVG_TapeRecorder::onGroupEnd() { end(SVG_Tape::OP_GROUP_END); }
+
+void SVG_TapeRecorder::onUse(const SVGAttributes &attributes) {
+    begin(SVG_Tape::OP_USE_BEGIN, attributes);
+}
+
+void SVG_TapeRecorder::onUseEnd() { end(SVG_Tape::OP_USE_END); }
+
+void SVG_TapeRecorder::onPath(const SVGPath &path) {
+    uint32_t index = attributes(path.attributes);
+    uint32_t words[] = {SVG_Tape::OP_PATH,
+                        _depth,
+                        index,
+                        uint32_t(_tape->_commands.size()),
+                        uint32_t(path.command_count),
+                        uint32_t(_tape->_coordinates.size()),
+                        uint32_t(path.coordinate_count)};
+    _tape->_words.insert(_tape->_words.end(), words, words + 7);
+    _tape->_commands.insert(_tape->_commands.end(), path.commands,
+                            path.commands + path.command_count);
+    _tape->_coordinates.insert(_tape->_coordinates.end(), path.coordinates,
+                               path.coordinates + path.coordinate_count);
+}
+
+} // namespace MonkSVG
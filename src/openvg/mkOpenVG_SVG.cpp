@@ -305,6 +305,13 @@ namespace MonkSVG {
         data[2] = x2; data[3] = y2;
         vgAppendPathData(_current_group->current_path->path, 1, &seg, data);
     }
+
+    void OpenVG_SVGHandler::onPathSQuad( float x2, float y2) {
+        VGubyte seg = VG_SQUAD_TO | openVGRelative();
+        VGfloat data[2];
+        data[0] = x2; data[1] = y2;
+        vgAppendPathData(_current_group->current_path->path, 1, &seg, data);
+    }
 	
 	void OpenVG_SVGHandler::onPathArc( float rx, float ry, float x_axis_rotation, int large_arc_flag, int sweep_flag, float x, float y ) {
 		
@@ -341,6 +348,58 @@ namespace MonkSVG {
 		vguRect( _current_group->current_path->path, x, y, w, h );
 	}
 
+	// the segments go to vgAppendPathData together, in runs between the
+	// rects, and the coordinates as the parser gave them
+	void OpenVG_SVGHandler::onPath( const SVGPath& path ) {
+		onPathBegin();
+		
+		VGPath vg_path = _current_group->current_path->path;
+		const float* c = path.coordinates;
+		const float* run = c;	// the coordinates for _segments
+		_segments.clear();
+		for ( size_t i = 0; i < path.command_count; i++ ) {
+			unsigned char command = path.commands[i];
+			VGubyte seg = ( command & SVG_PATH_RELATIVE ) ? VG_RELATIVE : VG_ABSOLUTE;
+			switch ( command & SVG_PATH_COMMAND_MASK ) {
+				case SVG_PATH_CLOSE:			seg = VG_CLOSE_PATH; break;
+				case SVG_PATH_MOVE_TO:			seg |= VG_MOVE_TO; break;
+				case SVG_PATH_LINE_TO:			seg |= VG_LINE_TO; break;
+				case SVG_PATH_HORIZONTAL_LINE:	seg |= VG_HLINE_TO; break;
+				case SVG_PATH_VERTICAL_LINE:	seg |= VG_VLINE_TO; break;
+				case SVG_PATH_CUBIC:			seg |= VG_CUBIC_TO; break;
+				case SVG_PATH_SCUBIC:			seg |= VG_SCUBIC_TO; break;
+				case SVG_PATH_QUAD:				seg |= VG_QUAD_TO; break;
+				case SVG_PATH_SQUAD:			seg |= VG_SQUAD_TO; break;
+				case SVG_PATH_ARC:
+					if ( command & SVG_PATH_ARC_LARGE ) {
+						seg |= ( command & SVG_PATH_ARC_SWEEP ) ? VG_LCCWARC_TO : VG_LCWARC_TO;
+					} else {
+						seg |= ( command & SVG_PATH_ARC_SWEEP ) ? VG_SCCWARC_TO : VG_SCWARC_TO;
+					}
+					break;
+				case SVG_PATH_RECT:
+					if ( !_segments.empty() ) {
+						vgAppendPathData( vg_path, VGint( _segments.size() ), &_segments[0], run );
+						_segments.clear();
+					}
+					vguRect( vg_path, c[0], c[1], c[2], c[3] );
+					c += svg_path_coordinates( command );
+					run = c;
+					continue;
+			}
+			_segments.push_back( seg );
+			c += svg_path_coordinates( command );
+		}
+		if ( !_segments.empty() ) {
+			vgAppendPathData( vg_path, VGint( _segments.size() ), &_segments[0], run );
+		}
+		
+		// the paint, transform and id as they always came
+		SVGBatchAdapter<ISVGHandler>::apply( *this, path.attributes );
+		
+		onPathEnd();
+	}
+
 	
 	void OpenVG_SVGHandler::onPathFillColor( unsigned int color ) {
 		if( _mode == kGroupParseMode ) {
@@ -23,13 +23,14 @@ distribution.
 */
 
 #include <ctype.h>
+#include <new>
 
 #ifdef TIXML_USE_STL
 #include <sstream>
 #include <iostream>
 #endif
 
-#include "tinyxml.h"
+#include "tinyxml/tinyxml.h"
 
 FILE* TiXmlFOpen( const char* filename, const char* mode );
 
@@ -133,6 +134,138 @@ void TiXmlBase::EncodeString( const TIXML_STRING& str, TIXML_STRING* outString )
 }
 
 
+void* TiXmlArena::Alloc( size_t size )
+{
+	return Grab( size, sizeof( double ) > sizeof( void* ) ? sizeof( double ) : sizeof( void* ) );
+}
+
+
+char* TiXmlArena::StrDup( const char* str, size_t length )
+{
+	char* copy = Grab( length + 1, 1 );
+	memcpy( copy, str, length );
+	copy[length] = 0;
+	return copy;
+}
+
+
+char* TiXmlArena::PaddedDup( const char* str, size_t length )
+{
+	const size_t size = TiXmlPaddedScan::Size( length );
+	char* copy = Grab( size, TiXmlPaddedScan::ALIGN );
+	memcpy( copy, str, length );
+	memset( copy + length, 0, size - length );
+	return copy;
+}
+
+
+char* TiXmlArena::Grab( size_t size, size_t align )
+{
+	char* p = (char*)( ( (size_t) cursor + align - 1 ) & ~( align - 1 ) );
+	if ( !cursor || p + size > end )
+	{
+		// Blocks grow as the document does, so big documents take a
+		// handful of trips to the heap rather than one per node.
+		size_t blockSize = nextSize;
+		if ( blockSize < size + sizeof( Block ) + align - 1 )
+			blockSize = size + sizeof( Block ) + align - 1;
+		if ( nextSize < MAX_BLOCK_SIZE )
+			nextSize *= 2;
+
+		Block* block = (Block*) ::operator new( blockSize );
+		block->next = blocks;
+		blocks = block;
+		cursor = (char*)( block + 1 );
+		end = (char*) block + blockSize;
+		p = (char*)( ( (size_t) cursor + align - 1 ) & ~( align - 1 ) );
+	}
+	cursor = p + size;
+	return p;
+}
+
+
+void TiXmlArena::Clear()
+{
+	while ( blocks )
+	{
+		Block* next = blocks->next;
+		::operator delete( blocks );
+		blocks = next;
+	}
+	cursor = end = 0;
+	nextSize = MIN_BLOCK_SIZE;
+}
+
+
+void TiXmlArena::Rewind()
+{
+	if ( !blocks )
+		return;
+	while ( blocks->next )
+	{
+		Block* next = blocks->next->next;
+		::operator delete( blocks->next );
+		blocks->next = next;
+	}
+	cursor = (char*)( blocks + 1 );
+}
+
+
+TiXmlAtomTable::TiXmlAtomTable( const char* const* _names, int _count )
+	: names( _names ), count( _count )
+{
+	// At most half full, so probe sequences stay short.
+	unsigned size = 8;
+	while ( size < (unsigned) count * 2 )
+		size *= 2;
+	mask = size - 1;
+	slots = new int[size];
+	memset( slots, 0, size * sizeof( int ) );
+
+	for( int i=0; i<count; ++i )
+	{
+		unsigned slot = Hash( names[i], strlen( names[i] ) ) & mask;
+		while ( slots[slot] )
+			slot = ( slot + 1 ) & mask;
+		slots[slot] = i + 1;
+	}
+}
+
+
+unsigned TiXmlAtomTable::Hash( const char* name, size_t length )
+{
+	// FNV-1a
+	unsigned hash = 2166136261u;
+	for( size_t i=0; i<length; ++i )
+	{
+		hash ^= (unsigned char) name[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+int TiXmlAtomTable::Find( const char* name, size_t length ) const
+{
+	for( unsigned slot = Hash( name, length ) & mask; slots[slot]; slot = ( slot + 1 ) & mask )
+	{
+		const char* candidate = names[ slots[slot] - 1 ];
+		if ( strncmp( candidate, name, length ) == 0 && candidate[length] == 0 )
+			return slots[slot] - 1;
+	}
+	return TIXML_NO_ATOM;
+}
+
+
+void TiXmlBase::Destroy( TiXmlBase* base )
+{
+	if ( base && base->inArena )
+		base->~TiXmlBase();
+	else
+		delete base;
+}
+
+
 TiXmlNode::TiXmlNode( NodeType _type ) : TiXmlBase()
 {
 	parent = 0;
@@ -141,6 +274,15 @@ TiXmlNode::TiXmlNode( NodeType _type ) : TiXmlBase()
 	lastChild = 0;
 	prev = 0;
 	next = 0;
+	valueInSitu = 0;
+}
+
+
+void TiXmlNode::NoteHeap()
+{
+	TiXmlDocument* document = GetDocument();
+	if ( document )
+		document->SetHeapInTree();
 }
 
 
@@ -153,14 +295,14 @@ TiXmlNode::~TiXmlNode()
 	{
 		temp = node;
 		node = node->next;
-		delete temp;
+		Destroy( temp );
 	}	
 }
 
 
 void TiXmlNode::CopyTo( TiXmlNode* target ) const
 {
-	target->SetValue (value.c_str() );
+	target->SetValue (Value() );
 	target->userData = userData; 
 	target->location = location;
 }
@@ -175,7 +317,7 @@ void TiXmlNode::Clear()
 	{
 		temp = node;
 		node = node->next;
-		delete temp;
+		Destroy( temp );
 	}	
 
 	firstChild = 0;
@@ -196,6 +338,8 @@ TiXmlNode* TiXmlNode::LinkEndChild( TiXmlNode* node )
 	}
 
 	node->parent = this;
+	if ( !node->inArena && ( inArena || type == TINYXML_DOCUMENT ) )
+		NoteHeap();
 
 	node->prev = lastChild;
 	node->next = 0;
@@ -240,6 +384,8 @@ TiXmlNode* TiXmlNode::InsertBeforeChild( TiXmlNode* beforeThis, const TiXmlNode&
 	if ( !node )
 		return 0;
 	node->parent = this;
+	if ( inArena || type == TINYXML_DOCUMENT )
+		NoteHeap();
 
 	node->next = beforeThis;
 	node->prev = beforeThis->prev;
@@ -272,6 +418,8 @@ TiXmlNode* TiXmlNode::InsertAfterChild( TiXmlNode* afterThis, const TiXmlNode& a
 	if ( !node )
 		return 0;
 	node->parent = this;
+	if ( inArena || type == TINYXML_DOCUMENT )
+		NoteHeap();
 
 	node->prev = afterThis;
 	node->next = afterThis->next;
@@ -322,8 +470,10 @@ TiXmlNode* TiXmlNode::ReplaceChild( TiXmlNode* replaceThis, const TiXmlNode& wit
 	else
 		firstChild = node;
 
-	delete replaceThis;
+	Destroy( replaceThis );
 	node->parent = this;
+	if ( inArena || type == TINYXML_DOCUMENT )
+		NoteHeap();
 	return node;
 }
 
@@ -350,7 +500,7 @@ bool TiXmlNode::RemoveChild( TiXmlNode* removeThis )
 	else
 		firstChild = removeThis->next;
 
-	delete removeThis;
+	Destroy( removeThis );
 	return true;
 }
 
@@ -441,7 +591,7 @@ void TiXmlElement::RemoveAttribute( const char * name )
 	if ( node )
 	{
 		attributeSet.Remove( node );
-		delete node;
+		Destroy( node );
 	}
 }
 
@@ -522,6 +672,7 @@ TiXmlElement::TiXmlElement (const char * _value)
 	: TiXmlNode( TiXmlNode::TINYXML_ELEMENT )
 {
 	firstChild = lastChild = 0;
+	atom = TIXML_NO_ATOM;
 	value = _value;
 }
 
@@ -531,6 +682,7 @@ TiXmlElement::TiXmlElement( const std::string& _value )
 	: TiXmlNode( TiXmlNode::TINYXML_ELEMENT )
 {
 	firstChild = lastChild = 0;
+	atom = TIXML_NO_ATOM;
 	value = _value;
 }
 #endif
@@ -540,6 +692,7 @@ TiXmlElement::TiXmlElement( const TiXmlElement& copy)
 	: TiXmlNode( TiXmlNode::TINYXML_ELEMENT )
 {
 	firstChild = lastChild = 0;
+	atom = TIXML_NO_ATOM;
 	copy.CopyTo( this );	
 }
 
@@ -564,7 +717,7 @@ void TiXmlElement::ClearThis()
 	{
 		TiXmlAttribute* node = attributeSet.First();
 		attributeSet.Remove( node );
-		delete node;
+		Destroy( node );
 	}
 }
 
@@ -578,12 +731,21 @@ const char* TiXmlElement::Attribute( const char* name ) const
 }
 
 
+const char* TiXmlElement::AttributeView( int atom ) const
+{
+	const TiXmlAttribute* node = attributeSet.Find( atom );
+	if ( node )
+		return node->Value();
+	return 0;
+}
+
+
 #ifdef TIXML_USE_STL
-const std::string* TiXmlElement::Attribute( const std::string& name ) const
+const char* TiXmlElement::Attribute( const std::string& name ) const
 {
 	const TiXmlAttribute* attrib = attributeSet.Find( name );
 	if ( attrib )
-		return &attrib->ValueStr();
+		return attrib->Value();
 	return 0;
 }
 #endif
@@ -605,13 +767,13 @@ const char* TiXmlElement::Attribute( const char* name, int* i ) const
 
 
 #ifdef TIXML_USE_STL
-const std::string* TiXmlElement::Attribute( const std::string& name, int* i ) const
+const char* TiXmlElement::Attribute( const std::string& name, int* i ) const
 {
 	const TiXmlAttribute* attrib = attributeSet.Find( name );
-	const std::string* result = 0;
+	const char* result = 0;
 
 	if ( attrib ) {
-		result = &attrib->ValueStr();
+		result = attrib->Value();
 		if ( i ) {
 			attrib->QueryIntValue( i );
 		}
@@ -637,13 +799,13 @@ const char* TiXmlElement::Attribute( const char* name, double* d ) const
 
 
 #ifdef TIXML_USE_STL
-const std::string* TiXmlElement::Attribute( const std::string& name, double* d ) const
+const char* TiXmlElement::Attribute( const std::string& name, double* d ) const
 {
 	const TiXmlAttribute* attrib = attributeSet.Find( name );
-	const std::string* result = 0;
+	const char* result = 0;
 
 	if ( attrib ) {
-		result = &attrib->ValueStr();
+		result = attrib->Value();
 		if ( d ) {
 			attrib->QueryDoubleValue( d );
 		}
@@ -695,6 +857,8 @@ int TiXmlElement::QueryDoubleAttribute( const std::string& name, double* dval )
 
 void TiXmlElement::SetAttribute( const char * name, int val )
 {	
+	if ( inArena )
+		NoteHeap();
 	TiXmlAttribute* attrib = attributeSet.FindOrCreate( name );
 	if ( attrib ) {
 		attrib->SetIntValue( val );
@@ -705,6 +869,8 @@ void TiXmlElement::SetAttribute( const char * name, int val )
 #ifdef TIXML_USE_STL
 void TiXmlElement::SetAttribute( const std::string& name, int val )
 {	
+	if ( inArena )
+		NoteHeap();
 	TiXmlAttribute* attrib = attributeSet.FindOrCreate( name );
 	if ( attrib ) {
 		attrib->SetIntValue( val );
@@ -715,6 +881,8 @@ void TiXmlElement::SetAttribute( const std::string& name, int val )
 
 void TiXmlElement::SetDoubleAttribute( const char * name, double val )
 {	
+	if ( inArena )
+		NoteHeap();
 	TiXmlAttribute* attrib = attributeSet.FindOrCreate( name );
 	if ( attrib ) {
 		attrib->SetDoubleValue( val );
@@ -725,6 +893,8 @@ void TiXmlElement::SetDoubleAttribute( const char * name, double val )
 #ifdef TIXML_USE_STL
 void TiXmlElement::SetDoubleAttribute( const std::string& name, double val )
 {	
+	if ( inArena )
+		NoteHeap();
 	TiXmlAttribute* attrib = attributeSet.FindOrCreate( name );
 	if ( attrib ) {
 		attrib->SetDoubleValue( val );
@@ -735,6 +905,8 @@ void TiXmlElement::SetDoubleAttribute( const std::string& name, double val )
 
 void TiXmlElement::SetAttribute( const char * cname, const char * cvalue )
 {
+	if ( inArena )
+		NoteHeap();
 	TiXmlAttribute* attrib = attributeSet.FindOrCreate( cname );
 	if ( attrib ) {
 		attrib->SetValue( cvalue );
@@ -745,6 +917,8 @@ void TiXmlElement::SetAttribute( const char * cname, const char * cvalue )
 #ifdef TIXML_USE_STL
 void TiXmlElement::SetAttribute( const std::string& _name, const std::string& _value )
 {
+	if ( inArena )
+		NoteHeap();
 	TiXmlAttribute* attrib = attributeSet.FindOrCreate( _name );
 	if ( attrib ) {
 		attrib->SetValue( _value );
@@ -761,7 +935,7 @@ void TiXmlElement::Print( FILE* cfile, int depth ) const
 		fprintf( cfile, "    " );
 	}
 
-	fprintf( cfile, "<%s", value.c_str() );
+	fprintf( cfile, "<%s", Value() );
 
 	const TiXmlAttribute* attrib;
 	for ( attrib = attributeSet.First(); attrib; attrib = attrib->Next() )
@@ -783,7 +957,7 @@ void TiXmlElement::Print( FILE* cfile, int depth ) const
 	{
 		fprintf( cfile, ">" );
 		firstChild->Print( cfile, depth + 1 );
-		fprintf( cfile, "</%s>", value.c_str() );
+		fprintf( cfile, "</%s>", Value() );
 	}
 	else
 	{
@@ -801,7 +975,7 @@ void TiXmlElement::Print( FILE* cfile, int depth ) const
 		for( i=0; i<depth; ++i ) {
 			fprintf( cfile, "    " );
 		}
-		fprintf( cfile, "</%s>", value.c_str() );
+		fprintf( cfile, "</%s>", Value() );
 	}
 }
 
@@ -810,6 +984,7 @@ void TiXmlElement::CopyTo( TiXmlElement* target ) const
 {
 	// superclass:
 	TiXmlNode::CopyTo( target );
+	target->atom = atom;
 
 	// Element class: 
 	// Clone the attributes, then clone the children.
@@ -818,7 +993,9 @@ void TiXmlElement::CopyTo( TiXmlElement* target ) const
 	attribute;
 	attribute = attribute->Next() )
 	{
-		target->SetAttribute( attribute->Name(), attribute->Value() );
+		TiXmlAttribute* copy = target->attributeSet.FindOrCreate( attribute->Name() );
+		copy->SetValue( attribute->Value() );
+		copy->SetAtom( attribute->Atom() );
 	}
 
 	TiXmlNode* node = 0;
@@ -870,6 +1047,12 @@ TiXmlDocument::TiXmlDocument() : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT )
 {
 	tabsize = 4;
 	useMicrosoftBOM = false;
+	parseInSitu = false;
+	heapInTree = false;
+	atomTable = 0;
+	elementTable = 0;
+	skipTable = 0;
+	condenseWhiteSpaceOnParse = condenseWhiteSpace;
 	ClearError();
 }
 
@@ -877,6 +1060,12 @@ TiXmlDocument::TiXmlDocument( const char * documentName ) : TiXmlNode( TiXmlNode
 {
 	tabsize = 4;
 	useMicrosoftBOM = false;
+	parseInSitu = false;
+	heapInTree = false;
+	atomTable = 0;
+	elementTable = 0;
+	skipTable = 0;
+	condenseWhiteSpaceOnParse = condenseWhiteSpace;
 	value = documentName;
 	ClearError();
 }
@@ -887,6 +1076,12 @@ TiXmlDocument::TiXmlDocument( const std::string& documentName ) : TiXmlNode( TiX
 {
 	tabsize = 4;
 	useMicrosoftBOM = false;
+	parseInSitu = false;
+	heapInTree = false;
+	atomTable = 0;
+	elementTable = 0;
+	skipTable = 0;
+	condenseWhiteSpaceOnParse = condenseWhiteSpace;
     value = documentName;
 	ClearError();
 }
@@ -895,13 +1090,32 @@ TiXmlDocument::TiXmlDocument( const std::string& documentName ) : TiXmlNode( TiX
 
 TiXmlDocument::TiXmlDocument( const TiXmlDocument& copy ) : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT )
 {
+	parseInSitu = false;
+	heapInTree = false;
+	atomTable = 0;
+	elementTable = 0;
+	skipTable = 0;
+	condenseWhiteSpaceOnParse = condenseWhiteSpace;
 	copy.CopyTo( this );
 }
 
 
+TiXmlDocument::~TiXmlDocument()
+{
+	// A tree that was only parsed lives in the arena, strings and all, and
+	// its destructors have nothing to release, so it goes with the arena.
+	// Anything else may reach the heap and is destroyed node by node first.
+	if ( heapInTree )
+		Clear();
+	firstChild = lastChild = 0;
+}
+
+
 void TiXmlDocument::operator=( const TiXmlDocument& copy )
 {
 	Clear();
+	arena.Clear();
+	heapInTree = false;
 	copy.CopyTo( this );
 }
 
@@ -1077,6 +1291,10 @@ void TiXmlDocument::CopyTo( TiXmlDocument* target ) const
 	target->tabsize = tabsize;
 	target->errorLocation = errorLocation;
 	target->useMicrosoftBOM = useMicrosoftBOM;
+	target->atomTable = atomTable;
+	target->elementTable = elementTable;
+	target->skipTable = skipTable;
+	target->condenseWhiteSpaceOnParse = condenseWhiteSpaceOnParse;
 
 	TiXmlNode* node = 0;
 	for ( node = firstChild; node; node = node->NextSibling() )
@@ -1126,7 +1344,7 @@ const TiXmlAttribute* TiXmlAttribute::Next() const
 {
 	// We are using knowledge of the sentinel. The sentinel
 	// have a value or name.
-	if ( next->value.empty() && next->name.empty() )
+	if ( !*next->Value() && !*next->Name() )
 		return 0;
 	return next;
 }
@@ -1136,7 +1354,7 @@ TiXmlAttribute* TiXmlAttribute::Next()
 {
 	// We are using knowledge of the sentinel. The sentinel
 	// have a value or name.
-	if ( next->value.empty() && next->name.empty() )
+	if ( !*next->Value() && !*next->Name() )
 		return 0;
 	return next;
 }
@@ -1146,7 +1364,7 @@ const TiXmlAttribute* TiXmlAttribute::Previous() const
 {
 	// We are using knowledge of the sentinel. The sentinel
 	// have a value or name.
-	if ( prev->value.empty() && prev->name.empty() )
+	if ( !*prev->Value() && !*prev->Name() )
 		return 0;
 	return prev;
 }
@@ -1156,7 +1374,7 @@ TiXmlAttribute* TiXmlAttribute::Previous()
 {
 	// We are using knowledge of the sentinel. The sentinel
 	// have a value or name.
-	if ( prev->value.empty() && prev->name.empty() )
+	if ( !*prev->Value() && !*prev->Name() )
 		return 0;
 	return prev;
 }
@@ -1166,10 +1384,11 @@ void TiXmlAttribute::Print( FILE* cfile, int /*depth*/, TIXML_STRING* str ) cons
 {
 	TIXML_STRING n, v;
 
-	EncodeString( name, &n );
-	EncodeString( value, &v );
+	const TIXML_STRING raw = ValueTStr();
+	EncodeString( NameTStr(), &n );
+	EncodeString( raw, &v );
 
-	if (value.find ('\"') == TIXML_STRING::npos) {
+	if (raw.find ('\"') == TIXML_STRING::npos) {
 		if ( cfile ) {
 		fprintf (cfile, "%s=\"%s\"", n.c_str(), v.c_str() );
 		}
@@ -1188,16 +1407,23 @@ void TiXmlAttribute::Print( FILE* cfile, int /*depth*/, TIXML_STRING* str ) cons
 }
 
 
+void TiXmlAttribute::NoteHeap()
+{
+	if ( document )
+		document->SetHeapInTree();
+}
+
+
 int TiXmlAttribute::QueryIntValue( int* ival ) const
 {
-	if ( TIXML_SSCANF( value.c_str(), "%d", ival ) == 1 )
+	if ( TIXML_SSCANF( Value(), "%d", ival ) == 1 )
 		return TIXML_SUCCESS;
 	return TIXML_WRONG_TYPE;
 }
 
 int TiXmlAttribute::QueryDoubleValue( double* dval ) const
 {
-	if ( TIXML_SSCANF( value.c_str(), "%lf", dval ) == 1 )
+	if ( TIXML_SSCANF( Value(), "%lf", dval ) == 1 )
 		return TIXML_SUCCESS;
 	return TIXML_WRONG_TYPE;
 }
@@ -1226,12 +1452,12 @@ void TiXmlAttribute::SetDoubleValue( double _value )
 
 int TiXmlAttribute::IntValue() const
 {
-	return atoi (value.c_str ());
+	return atoi (Value ());
 }
 
 double  TiXmlAttribute::DoubleValue() const
 {
-	return atof (value.c_str ());
+	return atof (Value ());
 }
 
 
@@ -1255,7 +1481,7 @@ void TiXmlComment::Print( FILE* cfile, int depth ) const
 	{
 		fprintf( cfile,  "    " );
 	}
-	fprintf( cfile, "<!--%s-->", value.c_str() );
+	fprintf( cfile, "<!--%s-->", Value() );
 }
 
 
@@ -1293,12 +1519,12 @@ void TiXmlText::Print( FILE* cfile, int depth ) const
 		for ( i=0; i<depth; i++ ) {
 			fprintf( cfile, "    " );
 		}
-		fprintf( cfile, "<![CDATA[%s]]>\n", value.c_str() );	// unformatted output
+		fprintf( cfile, "<![CDATA[%s]]>\n", Value() );	// unformatted output
 	}
 	else
 	{
 		TIXML_STRING buffer;
-		EncodeString( value, &buffer );
+		EncodeString( ValueTStr(), &buffer );
 		fprintf( cfile, "%s", buffer.c_str() );
 	}
 }
@@ -1335,6 +1561,7 @@ TiXmlDeclaration::TiXmlDeclaration( const char * _version,
 									const char * _standalone )
 	: TiXmlNode( TiXmlNode::TINYXML_DECLARATION )
 {
+	versionInSitu = encodingInSitu = standaloneInSitu = 0;
 	version = _version;
 	encoding = _encoding;
 	standalone = _standalone;
@@ -1347,6 +1574,7 @@ TiXmlDeclaration::TiXmlDeclaration(	const std::string& _version,
 									const std::string& _standalone )
 	: TiXmlNode( TiXmlNode::TINYXML_DECLARATION )
 {
+	versionInSitu = encodingInSitu = standaloneInSitu = 0;
 	version = _version;
 	encoding = _encoding;
 	standalone = _standalone;
@@ -1357,6 +1585,7 @@ TiXmlDeclaration::TiXmlDeclaration(	const std::string& _version,
 TiXmlDeclaration::TiXmlDeclaration( const TiXmlDeclaration& copy )
 	: TiXmlNode( TiXmlNode::TINYXML_DECLARATION )
 {
+	versionInSitu = encodingInSitu = standaloneInSitu = 0;
 	copy.CopyTo( this );	
 }
 
@@ -1373,17 +1602,17 @@ void TiXmlDeclaration::Print( FILE* cfile, int /*depth*/, TIXML_STRING* str ) co
 	if ( cfile ) fprintf( cfile, "<?xml " );
 	if ( str )	 (*str) += "<?xml ";
 
-	if ( !version.empty() ) {
-		if ( cfile ) fprintf (cfile, "version=\"%s\" ", version.c_str ());
-		if ( str ) { (*str) += "version=\""; (*str) += version; (*str) += "\" "; }
+	if ( *Version() ) {
+		if ( cfile ) fprintf (cfile, "version=\"%s\" ", Version ());
+		if ( str ) { (*str) += "version=\""; (*str) += Version(); (*str) += "\" "; }
 	}
-	if ( !encoding.empty() ) {
-		if ( cfile ) fprintf (cfile, "encoding=\"%s\" ", encoding.c_str ());
-		if ( str ) { (*str) += "encoding=\""; (*str) += encoding; (*str) += "\" "; }
+	if ( *Encoding() ) {
+		if ( cfile ) fprintf (cfile, "encoding=\"%s\" ", Encoding ());
+		if ( str ) { (*str) += "encoding=\""; (*str) += Encoding(); (*str) += "\" "; }
 	}
-	if ( !standalone.empty() ) {
-		if ( cfile ) fprintf (cfile, "standalone=\"%s\" ", standalone.c_str ());
-		if ( str ) { (*str) += "standalone=\""; (*str) += standalone; (*str) += "\" "; }
+	if ( *Standalone() ) {
+		if ( cfile ) fprintf (cfile, "standalone=\"%s\" ", Standalone ());
+		if ( str ) { (*str) += "standalone=\""; (*str) += Standalone(); (*str) += "\" "; }
 	}
 	if ( cfile ) fprintf( cfile, "?>" );
 	if ( str )	 (*str) += "?>";
@@ -1394,9 +1623,10 @@ void TiXmlDeclaration::CopyTo( TiXmlDeclaration* target ) const
 {
 	TiXmlNode::CopyTo( target );
 
-	target->version = version;
-	target->encoding = encoding;
-	target->standalone = standalone;
+	target->version = Version();
+	target->encoding = Encoding();
+	target->standalone = Standalone();
+	target->versionInSitu = target->encodingInSitu = target->standaloneInSitu = 0;
 }
 
 
@@ -1422,7 +1652,7 @@ void TiXmlUnknown::Print( FILE* cfile, int depth ) const
 {
 	for ( int i=0; i<depth; i++ )
 		fprintf( cfile, "    " );
-	fprintf( cfile, "<%s>", value.c_str() );
+	fprintf( cfile, "<%s>", Value() );
 }
 
 
@@ -1503,7 +1733,7 @@ TiXmlAttribute* TiXmlAttributeSet::Find( const std::string& name ) const
 {
 	for( TiXmlAttribute* node = sentinel.next; node != &sentinel; node = node->next )
 	{
-		if ( node->name == name )
+		if ( strcmp( node->Name(), name.c_str() ) == 0 )
 			return node;
 	}
 	return 0;
@@ -1526,7 +1756,20 @@ TiXmlAttribute* TiXmlAttributeSet::Find( const char* name ) const
 {
 	for( TiXmlAttribute* node = sentinel.next; node != &sentinel; node = node->next )
 	{
-		if ( strcmp( node->name.c_str(), name ) == 0 )
+		if ( strcmp( node->Name(), name ) == 0 )
+			return node;
+	}
+	return 0;
+}
+
+
+TiXmlAttribute* TiXmlAttributeSet::Find( int atom ) const
+{
+	if ( atom == TIXML_NO_ATOM )
+		return 0;
+	for( TiXmlAttribute* node = sentinel.next; node != &sentinel; node = node->next )
+	{
+		if ( node->atom == atom )
 			return node;
 	}
 	return 0;
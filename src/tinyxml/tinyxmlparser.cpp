@@ -24,8 +24,9 @@ distribution.
 
 #include <ctype.h>
 #include <stddef.h>
+#include <new>
 
-#include "tinyxml.h"
+#include "tinyxml/tinyxml.h"
 
 //#define DEBUG_PARSER
 #if defined( DEBUG_PARSER )
@@ -171,25 +172,46 @@ void TiXmlBase::ConvertUTF32ToUTF8( unsigned long input, char* output, int* leng
 class TiXmlParsingData
 {
 	friend class TiXmlDocument;
+	friend class TiXmlReader;
   public:
 	void Stamp( const char* now, TiXmlEncoding encoding );
 
 	const TiXmlCursor& Cursor()	{ return cursor; }
 
+	// True when the source buffer is writable and nodes should point into it.
+	bool InSitu() const			{ return inSitu; }
+
+	// Where the document wants its nodes made; null means the heap.
+	TiXmlArena* Arena() const	{ return arena; }
+
+	// True when the whole input has been checked to be well formed UTF-8.
+	bool ValidUTF8() const		{ return validUTF8; }
+
+	// The document's white space setting, fixed for the whole parse.
+	bool CondenseWhiteSpace() const	{ return condenseWhiteSpace; }
+
   private:
 	// Only used by the document!
-	TiXmlParsingData( const char* start, int _tabsize, int row, int col )
+	TiXmlParsingData( const char* start, int _tabsize, int row, int col, bool _inSitu, TiXmlArena* _arena, bool _condenseWhiteSpace )
 	{
 		assert( start );
 		stamp = start;
 		tabsize = _tabsize;
 		cursor.row = row;
 		cursor.col = col;
+		inSitu = _inSitu;
+		arena = _arena;
+		validUTF8 = false;
+		condenseWhiteSpace = _condenseWhiteSpace;
 	}
 
 	TiXmlCursor		cursor;
 	const char*		stamp;
 	int				tabsize;
+	bool			inSitu;
+	TiXmlArena*		arena;
+	bool			validUTF8;
+	bool			condenseWhiteSpace;
 };
 
 
@@ -211,6 +233,14 @@ void TiXmlParsingData::Stamp( const char* now, TiXmlEncoding encoding )
 
 	while ( p < now )
 	{
+		// Plain ASCII is a column a byte, whatever the encoding; only control
+		// characters and multi-byte characters need a closer look.
+		const char* run = TiXmlBase::ScanText( p, 0, TiXmlBase::SCAN_CONTROL | TiXmlBase::SCAN_NON_ASCII, now );
+		col += (int)( run - p );
+		p = run;
+		if ( p >= now )
+			break;
+
 		// Treat p as unsigned, so we have a happy compiler.
 		const unsigned char* pU = (const unsigned char*)p;
 
@@ -347,7 +377,7 @@ const char* TiXmlBase::SkipWhiteSpace( const char* p, TiXmlEncoding encoding )
 			}
 
 			if ( IsWhiteSpace( *p ) )		// Still using old rules for white space.
-				++p;
+				p = ScanWhiteSpace( p+1 );
 			else
 				break;
 		}
@@ -355,7 +385,7 @@ const char* TiXmlBase::SkipWhiteSpace( const char* p, TiXmlEncoding encoding )
 	else
 	{
 		while ( *p && IsWhiteSpace( *p ) )
-			++p;
+			p = ScanWhiteSpace( p+1 );
 	}
 
 	return p;
@@ -403,7 +433,8 @@ const char* TiXmlBase::ReadName( const char* p, TIXML_STRING * name, TiXmlEncodi
 	// Oddly, not supported on some comilers,
 	//name->clear();
 	// So use this:
-	*name = "";
+	if ( name )
+		*name = "";
 	assert( p );
 
 	// Names start with letters or underscores.
@@ -427,7 +458,7 @@ const char* TiXmlBase::ReadName( const char* p, TIXML_STRING * name, TiXmlEncodi
 			//(*name) += *p; // expensive
 			++p;
 		}
-		if ( p-start > 0 ) {
+		if ( name && p-start > 0 ) {
 			name->assign( start, p-start );
 		}
 		return p;
@@ -435,6 +466,78 @@ const char* TiXmlBase::ReadName( const char* p, TIXML_STRING * name, TiXmlEncodi
 	return 0;
 }
 
+bool TiXmlBase::IsSkipped( const char* p, const TiXmlAtomTable* skipTable, TiXmlEncoding encoding )
+{
+	const char* start = p + 1;
+	const char* end = ReadName( start, 0, encoding );
+	if ( !end )
+		return false;
+	if ( skipTable->Find( start, (int)( end - start ) ) != TIXML_NO_ATOM )
+		return true;
+	const char* colon = (const char*) memchr( start, ':', end - start );
+	return colon && skipTable->Find( start, (int)( colon + 1 - start ) ) != TIXML_NO_ATOM;
+}
+
+// Returns a pointer just past the first 'marker' at or after p, or 0.
+static const char* SkipPast( const char* p, const char* marker )
+{
+	p = strstr( p, marker );
+	return p ? p + strlen( marker ) : 0;
+}
+
+const char* TiXmlBase::SkipElement( const char* p, TiXmlEncoding encoding, int depth )
+{
+	while ( p && *p )
+	{
+		if ( *p != '<' )
+		{
+			p = strchr( p, '<' );
+		}
+		else if ( StringEqual( p, "<!--", false, encoding ) )
+		{
+			p = SkipPast( p + 4, "-->" );
+		}
+		else if ( StringEqual( p, "<![CDATA[", false, encoding ) )
+		{
+			p = SkipPast( p + 9, "]]>" );
+		}
+		else if ( *(p+1) == '?' )
+		{
+			p = SkipPast( p + 2, "?>" );
+		}
+		else
+		{
+			// A start tag, end tag or <!...>: find its '>', minding quoted
+			// attribute values, which may hold a '>' of their own.
+			const char* q = p + 1;
+			char quote = 0;
+			for ( ; *q; ++q )
+			{
+				if ( quote )
+				{
+					if ( *q == quote )
+						quote = 0;
+				}
+				else if ( *q == '"' || *q == '\'' )
+					quote = *q;
+				else if ( *q == '>' )
+					break;
+			}
+			if ( !*q )
+				return 0;
+
+			if ( *(p+1) == '/' )
+				--depth;
+			else if ( *(p+1) != '!' && *(q-1) != '/' )
+				++depth;
+			p = q + 1;
+			if ( depth == 0 )
+				return p;
+		}
+	}
+	return 0;
+}
+
 const char* TiXmlBase::GetEntity( const char* p, char* value, int* length, TiXmlEncoding encoding )
 {
 	// Presume an entity, and pull it out.
@@ -576,17 +679,29 @@ const char* TiXmlBase::ReadText(	const char* p,
 									bool trimWhiteSpace, 
 									const char* endTag, 
 									bool caseInsensitive,
-									TiXmlEncoding encoding )
+									TiXmlEncoding encoding,
+									bool validUTF8 )
 {
     *text = "";
-	if (    !trimWhiteSpace			// certain tags always keep whitespace
-		 || !condenseWhiteSpace )	// if true, whitespace is always kept
+	// Runs of plain text, up to the next entity or possible end tag, are
+	// copied in one go. Unchecked UTF-8 has to go through GetChar() a
+	// character at a time, so that a bad sequence is caught.
+	const char stop = caseInsensitive ? 0 : *endTag;
+	const int nonAscii = ( encoding == TIXML_ENCODING_UTF8 && !validUTF8 ) ? SCAN_NON_ASCII : 0;
+	if ( !trimWhiteSpace )	// certain tags, or documents, always keep whitespace
 	{
 		// Keep all the white space.
 		while (	   p && *p
 				&& !StringEqual( p, endTag, caseInsensitive, encoding )
 			  )
 		{
+			const char* run = stop ? ScanText( p, stop, nonAscii ) : p;
+			if ( run != p )
+			{
+				text->append( p, run - p );
+				p = run;
+				continue;
+			}
 			int len;
 			char cArr[4] = { 0, 0, 0, 0 };
 			p = GetChar( p, cArr, &len, encoding );
@@ -605,12 +720,12 @@ const char* TiXmlBase::ReadText(	const char* p,
 			if ( *p == '\r' || *p == '\n' )
 			{
 				whitespace = true;
-				++p;
+				p = ScanWhiteSpace( p+1 );
 			}
 			else if ( IsWhiteSpace( *p ) )
 			{
 				whitespace = true;
-				++p;
+				p = ScanWhiteSpace( p+1 );
 			}
 			else
 			{
@@ -621,6 +736,13 @@ const char* TiXmlBase::ReadText(	const char* p,
 					(*text) += ' ';
 					whitespace = false;
 				}
+				const char* run = stop ? ScanText( p, stop, nonAscii | SCAN_WHITESPACE ) : p;
+				if ( run != p )
+				{
+					text->append( p, run - p );
+					p = run;
+					continue;
+				}
 				int len;
 				char cArr[4] = { 0, 0, 0, 0 };
 				p = GetChar( p, cArr, &len, encoding );
@@ -636,6 +758,94 @@ const char* TiXmlBase::ReadText(	const char* p,
 	return p;
 }
 
+// Moves the bytes [p, end) down to q, which trails p, and returns the new end
+// of the output. Nothing has to move until decoding has opened up a gap.
+static inline char* MoveRun( char* q, const char* p, const char* end )
+{
+	if ( q != p )
+		memmove( q, p, end - p );
+	return q + ( end - p );
+}
+
+char* TiXmlBase::ReadTextInSitu(	char* p, 
+									char** text, 
+									char** textEnd, 
+									bool trimWhiteSpace, 
+									const char* endTag, 
+									bool caseInsensitive,
+									TiXmlEncoding encoding,
+									bool validUTF8 )
+{
+	// Same rules as ReadText, but the output is written back over the input.
+	// The write cursor 'q' can never overtake the read cursor 'p'.
+	char* q = p;
+	const char stop = caseInsensitive ? 0 : *endTag;
+	const int nonAscii = ( encoding == TIXML_ENCODING_UTF8 && !validUTF8 ) ? SCAN_NON_ASCII : 0;
+	if ( !trimWhiteSpace )	// certain tags, or documents, always keep whitespace
+	{
+		*text = q;
+		while (	   p && *p
+				&& !StringEqual( p, endTag, caseInsensitive, encoding )
+			  )
+		{
+			char* run = stop ? const_cast< char* >( ScanText( p, stop, nonAscii ) ) : p;
+			if ( run != p )
+			{
+				q = MoveRun( q, p, run );
+				p = run;
+				continue;
+			}
+			int len;
+			char cArr[4] = { 0, 0, 0, 0 };
+			p = const_cast< char* >( GetChar( p, cArr, &len, encoding ) );
+			for( int i=0; i<len; ++i )
+				*q++ = cArr[i];
+		}
+	}
+	else
+	{
+		bool whitespace = false;
+
+		// Remove leading white space:
+		p = const_cast< char* >( SkipWhiteSpace( p, encoding ) );
+		*text = q = p;
+		while (	   p && *p
+				&& !StringEqual( p, endTag, caseInsensitive, encoding ) )
+		{
+			if ( IsWhiteSpace( *p ) )
+			{
+				whitespace = true;
+				p = const_cast< char* >( ScanWhiteSpace( p+1 ) );
+			}
+			else
+			{
+				// Any run of whitespace becomes a single space.
+				if ( whitespace )
+				{
+					*q++ = ' ';
+					whitespace = false;
+				}
+				char* run = stop ? const_cast< char* >( ScanText( p, stop, nonAscii | SCAN_WHITESPACE ) ) : p;
+				if ( run != p )
+				{
+					q = MoveRun( q, p, run );
+					p = run;
+					continue;
+				}
+				int len;
+				char cArr[4] = { 0, 0, 0, 0 };
+				p = const_cast< char* >( GetChar( p, cArr, &len, encoding ) );
+				for( int i=0; i<len; ++i )
+					*q++ = cArr[i];
+			}
+		}
+	}
+	*textEnd = q;
+	if ( p && *p ) 
+		p += strlen( endTag );
+	return p;
+}
+
 #ifdef TIXML_USE_STL
 
 void TiXmlDocument::StreamIn( std::istream * in, TIXML_STRING * tag )
@@ -728,7 +938,28 @@ const char* TiXmlDocument::Parse( const char* p, TiXmlParsingData* prevData, TiX
 		location.row = 0;
 		location.col = 0;
 	}
-	TiXmlParsingData data( p, TabSize(), location.row, location.col );
+	// Nothing left in the document can be using the arena.
+	if ( !firstChild )
+	{
+		arena.Clear();
+		heapInTree = false;
+	}
+
+	// Parse a copy in the arena in-situ, rather than building a string for
+	// every name and value: then the whole tree lives in the arena.
+	const char* const source = p;
+	size_t padded = 0;
+	if ( !parseInSitu )
+	{
+		const size_t length = strlen( p );
+		p = arena.PaddedDup( p, length );
+		padded = TiXmlPaddedScan::Size( length );
+	}
+	const char* const start = p;
+	// Only our own copy may be scanned with SIMD.
+	TiXmlPaddedScan scan( start, padded );
+
+	TiXmlParsingData data( p, TabSize(), location.row, location.col, true, &arena, condenseWhiteSpaceOnParse );
 	location = data.Cursor();
 
 	if ( encoding == TIXML_ENCODING_UNKNOWN )
@@ -744,6 +975,11 @@ const char* TiXmlDocument::Parse( const char* p, TiXmlParsingData* prevData, TiX
 		}
 	}
 
+	// One pass over the bytes up front lets the tokenizer skip the per
+	// character UTF-8 handling everywhere else.
+	if ( encoding != TIXML_ENCODING_LEGACY )
+		data.validUTF8 = IsValidUTF8( p );
+
     p = SkipWhiteSpace( p, encoding );
 	if ( !p )
 	{
@@ -753,7 +989,7 @@ const char* TiXmlDocument::Parse( const char* p, TiXmlParsingData* prevData, TiX
 
 	while ( p && *p )
 	{
-		TiXmlNode* node = Identify( p, encoding );
+		TiXmlNode* node = Identify( p, encoding, &arena );
 		if ( node )
 		{
 			p = node->Parse( p, &data, encoding );
@@ -792,7 +1028,15 @@ const char* TiXmlDocument::Parse( const char* p, TiXmlParsingData* prevData, TiX
 	}
 
 	// All is well.
-	return p;
+	return p ? source + ( p - start ) : 0;
+}
+
+const char* TiXmlDocument::ParseInSitu( char* p, TiXmlEncoding encoding )
+{
+	parseInSitu = true;
+	const char* end = Parse( p, 0, encoding );
+	parseInSitu = false;
+	return end;
 }
 
 void TiXmlDocument::SetError( int err, const char* pError, TiXmlParsingData* data, TiXmlEncoding encoding )
@@ -815,7 +1059,7 @@ void TiXmlDocument::SetError( int err, const char* pError, TiXmlParsingData* dat
 }
 
 
-TiXmlNode* TiXmlNode::Identify( const char* p, TiXmlEncoding encoding )
+TiXmlNode* TiXmlNode::Identify( const char* p, TiXmlEncoding encoding, TiXmlArena* arena )
 {
 	TiXmlNode* returnNode = 0;
 
@@ -849,21 +1093,21 @@ TiXmlNode* TiXmlNode::Identify( const char* p, TiXmlEncoding encoding )
 		#ifdef DEBUG_PARSER
 			TIXML_LOG( "XML parsing Declaration\n" );
 		#endif
-		returnNode = new TiXmlDeclaration();
+		returnNode = ArenaNew< TiXmlDeclaration >( arena );
 	}
 	else if ( StringEqual( p, commentHeader, false, encoding ) )
 	{
 		#ifdef DEBUG_PARSER
 			TIXML_LOG( "XML parsing Comment\n" );
 		#endif
-		returnNode = new TiXmlComment();
+		returnNode = ArenaNew< TiXmlComment >( arena );
 	}
 	else if ( StringEqual( p, cdataHeader, false, encoding ) )
 	{
 		#ifdef DEBUG_PARSER
 			TIXML_LOG( "XML parsing CDATA\n" );
 		#endif
-		TiXmlText* text = new TiXmlText( "" );
+		TiXmlText* text = ArenaNew< TiXmlText >( arena, "" );
 		text->SetCDATA( true );
 		returnNode = text;
 	}
@@ -872,7 +1116,7 @@ TiXmlNode* TiXmlNode::Identify( const char* p, TiXmlEncoding encoding )
 		#ifdef DEBUG_PARSER
 			TIXML_LOG( "XML parsing Unknown(1)\n" );
 		#endif
-		returnNode = new TiXmlUnknown();
+		returnNode = ArenaNew< TiXmlUnknown >( arena );
 	}
 	else if (    IsAlpha( *(p+1), encoding )
 			  || *(p+1) == '_' )
@@ -880,14 +1124,14 @@ TiXmlNode* TiXmlNode::Identify( const char* p, TiXmlEncoding encoding )
 		#ifdef DEBUG_PARSER
 			TIXML_LOG( "XML parsing Element\n" );
 		#endif
-		returnNode = new TiXmlElement( "" );
+		returnNode = ArenaNew< TiXmlElement >( arena, "" );
 	}
 	else
 	{
 		#ifdef DEBUG_PARSER
 			TIXML_LOG( "XML parsing Unknown(2)\n" );
 		#endif
-		returnNode = new TiXmlUnknown();
+		returnNode = ArenaNew< TiXmlUnknown >( arena );
 	}
 
 	if ( returnNode )
@@ -1042,6 +1286,17 @@ void TiXmlElement::StreamIn (std::istream * in, TIXML_STRING * tag)
 
 const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding )
 {
+	bool empty;
+	p = ReadStartTag( p, data, encoding, &empty );
+	if ( !p || empty )
+		return p;
+	return ReadContent( p, data, encoding );
+}
+
+
+const char* TiXmlElement::ReadStartTag( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding, bool* empty )
+{
+	*empty = true;
 	p = SkipWhiteSpace( p, encoding );
 	TiXmlDocument* document = GetDocument();
 
@@ -1067,16 +1322,33 @@ const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 
 	// Read the name.
 	const char* pErr = p;
+	const bool inSitu = data && data->InSitu();
 
-    p = ReadName( p, &value, encoding );
+	p = ReadName( p, inSitu ? 0 : &value, encoding );
 	if ( !p || !*p )
 	{
 		if ( document )	document->SetError( TIXML_ERROR_FAILED_TO_READ_ELEMENT_NAME, pErr, data, encoding );
 		return 0;
 	}
 
-    TIXML_STRING endTag ("</");
-	endTag += value;
+	const size_t nameLength = p - pErr;
+	atom = ( document && document->ElementTable() ) ? document->ElementTable()->Find( pErr, nameLength ) : TIXML_NO_ATOM;
+
+	// In-situ, the name is terminated in the buffer. If it runs right into
+	// the '/' or '>' that closes the tag, the terminator has to wait until
+	// that character has been read.
+	char* nameEnd = 0;
+	if ( inSitu )
+	{
+		valueInSitu = pErr;
+		nameEnd = const_cast< char* >( p );
+		if ( IsWhiteSpace( *nameEnd ) )
+		{
+			*nameEnd = 0;
+			nameEnd = 0;
+			++p;
+		}
+	}
 
 	// Check for and read attributes. Also look for an empty
 	// tag or an end tag.
@@ -1098,48 +1370,34 @@ const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 				if ( document ) document->SetError( TIXML_ERROR_PARSING_EMPTY, p, data, encoding );		
 				return 0;
 			}
+			if ( nameEnd )
+				*nameEnd = 0;
 			return (p+1);
 		}
 		else if ( *p == '>' )
 		{
-			// Done with attributes (if there were any.)
-			// Read the value -- which can include other
-			// elements -- read the end tag, and return.
-			++p;
-			p = ReadValue( p, data, encoding );		// Note this is an Element method, and will set the error if one happens.
-			if ( !p || !*p ) {
-				// We were looking for the end tag, but found nothing.
-				// Fix for [ 1663758 ] Failure to report error on bad XML
-				if ( document ) document->SetError( TIXML_ERROR_READING_END_TAG, p, data, encoding );
-				return 0;
-			}
-
-			// We should find the end tag now
-			// note that:
-			// </foo > and
-			// </foo> 
-			// are both valid end tags.
-			if ( StringEqual( p, endTag.c_str(), false, encoding ) )
-			{
-				p += endTag.length();
-				p = SkipWhiteSpace( p, encoding );
-				if ( p && *p && *p == '>' ) {
-					++p;
-					return p;
-				}
-				if ( document ) document->SetError( TIXML_ERROR_READING_END_TAG, p, data, encoding );
-				return 0;
-			}
-			else
-			{
-				if ( document ) document->SetError( TIXML_ERROR_READING_END_TAG, p, data, encoding );
-				return 0;
-			}
+			// Done with attributes (if there were any.) The value,
+			// which can include other elements, and the end tag are
+			// left to ReadContent().
+			if ( nameEnd )
+				*nameEnd = 0;
+			*empty = false;
+			return p+1;
 		}
 		else
 		{
+			// An attribute butts right up against the name: it can't be
+			// terminated in place, so take a copy of it instead.
+			if ( nameEnd )
+			{
+				valueInSitu = data->Arena() ? data->Arena()->StrDup( pErr, nameLength ) : 0;
+				if ( !valueInSitu )
+					value.assign( pErr, nameLength );
+				nameEnd = 0;
+			}
+
 			// Try to read an attribute:
-			TiXmlAttribute* attrib = new TiXmlAttribute();
+			TiXmlAttribute* attrib = ArenaNew< TiXmlAttribute >( data ? data->Arena() : 0 );
 			if ( !attrib )
 			{
 				return 0;
@@ -1152,20 +1410,16 @@ const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 			if ( !p || !*p )
 			{
 				if ( document ) document->SetError( TIXML_ERROR_PARSING_ELEMENT, pErr, data, encoding );
-				delete attrib;
+				Destroy( attrib );
 				return 0;
 			}
 
 			// Handle the strange case of double attributes:
-			#ifdef TIXML_USE_STL
-			TiXmlAttribute* node = attributeSet.Find( attrib->NameTStr() );
-			#else
 			TiXmlAttribute* node = attributeSet.Find( attrib->Name() );
-			#endif
 			if ( node )
 			{
 				if ( document ) document->SetError( TIXML_ERROR_PARSING_ELEMENT, pErr, data, encoding );
-				delete attrib;
+				Destroy( attrib );
 				return 0;
 			}
 
@@ -1176,6 +1430,47 @@ const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 }
 
 
+const char* TiXmlElement::ReadContent( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding )
+{
+	TiXmlDocument* document = GetDocument();
+
+	// The end tag is "</" followed by the name; compare against the name in
+	// place rather than building the tag.
+	const size_t nameLength = strlen( Value() );
+
+	p = ReadValue( p, data, encoding );		// Note this is an Element method, and will set the error if one happens.
+	if ( !p || !*p ) {
+		// We were looking for the end tag, but found nothing.
+		// Fix for [ 1663758 ] Failure to report error on bad XML
+		if ( document ) document->SetError( TIXML_ERROR_READING_END_TAG, p, data, encoding );
+		return 0;
+	}
+
+	// We should find the end tag now
+	// note that:
+	// </foo > and
+	// </foo> 
+	// are both valid end tags.
+	if (    StringEqual( p, "</", false, encoding )
+		 && strncmp( p+2, Value(), nameLength ) == 0 )
+	{
+		p += 2 + nameLength;
+		p = SkipWhiteSpace( p, encoding );
+		if ( p && *p && *p == '>' ) {
+			++p;
+			return p;
+		}
+		if ( document ) document->SetError( TIXML_ERROR_READING_END_TAG, p, data, encoding );
+		return 0;
+	}
+	else
+	{
+		if ( document ) document->SetError( TIXML_ERROR_READING_END_TAG, p, data, encoding );
+		return 0;
+	}
+}
+
+
 const char* TiXmlElement::ReadValue( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding )
 {
 	TiXmlDocument* document = GetDocument();
@@ -1189,14 +1484,14 @@ const char* TiXmlElement::ReadValue( const char* p, TiXmlParsingData* data, TiXm
 		if ( *p != '<' )
 		{
 			// Take what we have, make a text element.
-			TiXmlText* textNode = new TiXmlText( "" );
+			TiXmlText* textNode = ArenaNew< TiXmlText >( data ? data->Arena() : 0, "" );
 
 			if ( !textNode )
 			{
 			    return 0;
 			}
 
-			if ( TiXmlBase::IsWhiteSpaceCondensed() )
+			if ( data ? data->CondenseWhiteSpace() : TiXmlBase::IsWhiteSpaceCondensed() )
 			{
 				p = textNode->Parse( p, data, encoding );
 			}
@@ -1210,7 +1505,7 @@ const char* TiXmlElement::ReadValue( const char* p, TiXmlParsingData* data, TiXm
 			if ( !textNode->Blank() )
 				LinkEndChild( textNode );
 			else
-				delete textNode;
+				Destroy( textNode );
 		} 
 		else 
 		{
@@ -1221,9 +1516,20 @@ const char* TiXmlElement::ReadValue( const char* p, TiXmlParsingData* data, TiXm
 			{
 				return p;
 			}
+			else if (    document && document->SkipTable()
+					  && IsSkipped( p, document->SkipTable(), encoding ) )
+			{
+				const char* start = p;
+				p = SkipElement( p, encoding );
+				if ( !p )
+				{
+					document->SetError( TIXML_ERROR_READING_END_TAG, start, data, encoding );
+					return 0;
+				}
+			}
 			else
 			{
-				TiXmlNode* node = Identify( p, encoding );
+				TiXmlNode* node = Identify( p, encoding, data ? data->Arena() : 0 );
 				if ( node )
 				{
 					p = node->Parse( p, data, encoding );
@@ -1289,10 +1595,14 @@ const char* TiXmlUnknown::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 	}
 	++p;
     value = "";
+	const bool inSitu = data && data->InSitu();
+	if ( inSitu )
+		valueInSitu = p;
 
 	while ( p && *p && *p != '>' )
 	{
-		value += *p;
+		if ( !inSitu )
+			value += *p;
 		++p;
 	}
 
@@ -1301,7 +1611,11 @@ const char* TiXmlUnknown::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 		if ( document )	document->SetError( TIXML_ERROR_PARSING_UNKNOWN, 0, 0, encoding );
 	}
 	if ( *p == '>' )
+	{
+		if ( inSitu )
+			*const_cast< char* >( p ) = 0;
 		return p+1;
+	}
 	return p;
 }
 
@@ -1374,14 +1688,23 @@ const char* TiXmlComment::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 	*/
 
     value = "";
+	const bool inSitu = data && data->InSitu();
+	if ( inSitu )
+		valueInSitu = p;
 	// Keep all the white space.
 	while (	p && *p && !StringEqual( p, endTag, false, encoding ) )
 	{
-		value.append( p, 1 );
+		if ( !inSitu )
+			value.append( p, 1 );
 		++p;
 	}
 	if ( p && *p ) 
+	{
+		char* textEnd = const_cast< char* >( p );
 		p += strlen( endTag );
+		if ( inSitu )
+			*textEnd = 0;
+	}
 
 	return p;
 }
@@ -1399,12 +1722,16 @@ const char* TiXmlAttribute::Parse( const char* p, TiXmlParsingData* data, TiXmlE
 	}
 	// Read the name, the '=' and the value.
 	const char* pErr = p;
-	p = ReadName( p, &name, encoding );
+	const bool inSitu = data && data->InSitu();
+	p = ReadName( p, inSitu ? 0 : &name, encoding );
 	if ( !p || !*p )
 	{
 		if ( document ) document->SetError( TIXML_ERROR_READING_ATTRIBUTES, pErr, data, encoding );
 		return 0;
 	}
+	if ( document && document->AtomTable() )
+		atom = document->AtomTable()->Find( pErr, p - pErr );
+	char* nameEnd = const_cast< char* >( p );
 	p = SkipWhiteSpace( p, encoding );
 	if ( !p || !*p || *p != '=' )
 	{
@@ -1413,6 +1740,13 @@ const char* TiXmlAttribute::Parse( const char* p, TiXmlParsingData* data, TiXmlE
 	}
 
 	++p;	// skip '='
+
+	// In-situ the name ends on white space or the '=' just read past.
+	if ( inSitu )
+	{
+		*nameEnd = 0;
+		nameInSitu = pErr;
+	}
 	p = SkipWhiteSpace( p, encoding );
 	if ( !p || !*p )
 	{
@@ -1424,24 +1758,38 @@ const char* TiXmlAttribute::Parse( const char* p, TiXmlParsingData* data, TiXmlE
 	const char SINGLE_QUOTE = '\'';
 	const char DOUBLE_QUOTE = '\"';
 
-	if ( *p == SINGLE_QUOTE )
-	{
-		++p;
-		end = "\'";		// single quote in string
-		p = ReadText( p, &value, false, end, false, encoding );
-	}
-	else if ( *p == DOUBLE_QUOTE )
+	if ( *p == SINGLE_QUOTE || *p == DOUBLE_QUOTE )
 	{
+		if ( *p == SINGLE_QUOTE )
+			end = "\'";		// single quote in string
+		else
+			end = "\"";		// double quote in string
 		++p;
-		end = "\"";		// double quote in string
-		p = ReadText( p, &value, false, end, false, encoding );
+
+		if ( inSitu )
+		{
+			// The closing quote has been read past, so the terminator
+			// can always go in place.
+			char* text;
+			char* textEnd;
+			p = ReadTextInSitu( const_cast< char* >( p ), &text, &textEnd, false, end, false, encoding, data->ValidUTF8() );
+			if ( p )
+			{
+				*textEnd = 0;
+				valueInSitu = text;
+			}
+		}
+		else
+		{
+			p = ReadText( p, &value, false, end, false, encoding, data && data->ValidUTF8() );
+		}
 	}
 	else
 	{
 		// All attribute values should be in single or double quotes.
 		// But this is such a common error that the parser will try
 		// its best, even without them.
-		value = "";
+		const char* start = p;
 		while (    p && *p											// existence
 				&& !IsWhiteSpace( *p )								// whitespace
 				&& *p != '/' && *p != '>' )							// tag end
@@ -1453,9 +1801,14 @@ const char* TiXmlAttribute::Parse( const char* p, TiXmlParsingData* data, TiXmlE
 				if ( document ) document->SetError( TIXML_ERROR_READING_ATTRIBUTES, p, data, encoding );
 				return 0;
 			}
-			value += *p;
 			++p;
 		}
+		// The end is still needed by the element, so in-situ this takes a
+		// copy in the arena.
+		if ( inSitu && data->Arena() )
+			valueInSitu = data->Arena()->StrDup( start, p - start );
+		else
+			value.assign( start, p - start );
 	}
 	return p;
 }
@@ -1517,25 +1870,57 @@ const char* TiXmlText::Parse( const char* p, TiXmlParsingData* data, TiXmlEncodi
 		}
 		p += strlen( startTag );
 
+		const bool inSitu = data && data->InSitu();
+		if ( inSitu )
+			valueInSitu = p;
+
 		// Keep all the white space, ignore the encoding, etc.
 		while (	   p && *p
 				&& !StringEqual( p, endTag, false, encoding )
 			  )
 		{
-			value += *p;
+			if ( !inSitu )
+				value += *p;
 			++p;
 		}
 
+		char* textEnd = const_cast< char* >( p );
 		TIXML_STRING dummy; 
 		p = ReadText( p, &dummy, false, endTag, false, encoding );
+		if ( inSitu )
+			*textEnd = 0;
 		return p;
 	}
 	else
 	{
-		bool ignoreWhite = true;
+		bool ignoreWhite = data ? data->CondenseWhiteSpace() : IsWhiteSpaceCondensed();
 
 		const char* end = "<";
-		p = ReadText( p, &value, ignoreWhite, end, false, encoding );
+		if ( data && data->InSitu() )
+		{
+			char* text;
+			char* textEnd;
+			p = ReadTextInSitu( const_cast< char* >( p ), &text, &textEnd, ignoreWhite, end, false, encoding, data->ValidUTF8() );
+			if ( !p )
+				return 0;
+			// The '<' is still needed by the next node, so the text can only
+			// be terminated in place if decoding left a gap in front of it.
+			if ( textEnd < p-1 )
+			{
+				*textEnd = 0;
+				valueInSitu = text;
+			}
+			else if ( data->Arena() )
+			{
+				valueInSitu = data->Arena()->StrDup( text, textEnd - text );
+			}
+			else
+			{
+				value.assign( text, textEnd - text );
+			}
+			return p-1;	// don't truncate the '<'
+		}
+		p = ReadText( p, &value, ignoreWhite, end, false, encoding, data && data->ValidUTF8() );
 		if ( p )
 			return p-1;	// don't truncate the '<'
 		return 0;
@@ -1587,6 +1972,7 @@ const char* TiXmlDeclaration::Parse( const char* p, TiXmlParsingData* data, TiXm
 	version = "";
 	encoding = "";
 	standalone = "";
+	versionInSitu = encodingInSitu = standaloneInSitu = 0;
 
 	while ( p && *p )
 	{
@@ -1601,19 +1987,28 @@ const char* TiXmlDeclaration::Parse( const char* p, TiXmlParsingData* data, TiXm
 		{
 			TiXmlAttribute attrib;
 			p = attrib.Parse( p, data, _encoding );		
-			version = attrib.Value();
+			if ( attrib.valueInSitu )
+				versionInSitu = attrib.valueInSitu;
+			else
+				version = attrib.Value();
 		}
 		else if ( StringEqual( p, "encoding", true, _encoding ) )
 		{
 			TiXmlAttribute attrib;
 			p = attrib.Parse( p, data, _encoding );		
-			encoding = attrib.Value();
+			if ( attrib.valueInSitu )
+				encodingInSitu = attrib.valueInSitu;
+			else
+				encoding = attrib.Value();
 		}
 		else if ( StringEqual( p, "standalone", true, _encoding ) )
 		{
 			TiXmlAttribute attrib;
 			p = attrib.Parse( p, data, _encoding );		
-			standalone = attrib.Value();
+			if ( attrib.valueInSitu )
+				standaloneInSitu = attrib.valueInSitu;
+			else
+				standalone = attrib.Value();
 		}
 		else
 		{
@@ -1627,9 +2022,211 @@ const char* TiXmlDeclaration::Parse( const char* p, TiXmlParsingData* data, TiXm
 
 bool TiXmlText::Blank() const
 {
-	for ( unsigned i=0; i<value.length(); i++ )
-		if ( !IsWhiteSpace( value[i] ) )
+	for ( const char* c = Value(); *c; ++c )
+		if ( !IsWhiteSpace( *c ) )
 			return false;
 	return true;
 }
 
+
+TiXmlReader::TiXmlReader( char* xml, TiXmlEncoding _encoding )
+	: padded( 0 ), paddedSize( 0 ), element( 0 ), data( 0 ), p( xml ), encoding( _encoding ), depth( 0 ), pendingEnd( false ), done( false )
+{
+	// The element belongs to the document, so it can report its errors.
+	element = new TiXmlElement( "" );
+	document.LinkEndChild( element );
+}
+
+
+TiXmlReader::TiXmlReader( const char* xml, size_t length, TiXmlEncoding _encoding )
+	: padded( 0 ), paddedSize( 0 ), element( 0 ), data( 0 ), p( 0 ), encoding( _encoding ), depth( 0 ), pendingEnd( false ), done( false )
+{
+	if ( xml )
+	{
+		p = source.PaddedDup( xml, length );
+		padded = p;
+		paddedSize = TiXmlPaddedScan::Size( length );
+	}
+	element = new TiXmlElement( "" );
+	document.LinkEndChild( element );
+}
+
+
+TiXmlReader::~TiXmlReader()
+{
+	delete data;
+}
+
+
+TiXmlReader::Event TiXmlReader::Fail( int err, const char* at )
+{
+	document.SetError( err, at, data, encoding );
+	return READ_ERROR;
+}
+
+
+void TiXmlReader::PushName()
+{
+	openNames.append( element->Value(), strlen( element->Value() ) + 1 );
+	++depth;
+}
+
+
+size_t TiXmlReader::LastName() const
+{
+	size_t start = openNames.length() - 1;
+	while ( start > 0 && openNames[start-1] )
+		--start;
+	return start;
+}
+
+
+void TiXmlReader::PopName()
+{
+	openNames.assign( openNames.c_str(), LastName() );
+	if ( --depth == 0 )
+		done = true;
+}
+
+
+TiXmlReader::Event TiXmlReader::Next()
+{
+	TiXmlPaddedScan scan( padded, paddedSize );
+	if ( document.Error() )
+		return READ_ERROR;
+	if ( pendingEnd )
+	{
+		pendingEnd = false;
+		PopName();
+		return ELEMENT_END;
+	}
+	if ( done )
+		return DOCUMENT_END;
+
+	if ( !data )
+	{
+		if ( !p )
+			return Fail( TiXmlBase::TIXML_ERROR_DOCUMENT_EMPTY, 0 );
+		if ( encoding == TIXML_ENCODING_UNKNOWN )
+			encoding = TIXML_ENCODING_UTF8;
+		data = new TiXmlParsingData( p, document.TabSize(), 0, 0, true, &document.arena, document.WhiteSpaceCondensed() );
+		if ( encoding == TIXML_ENCODING_UTF8 )
+			data->validUTF8 = TiXmlBase::IsValidUTF8( p );
+	}
+
+	for( ;; )
+	{
+		p = const_cast< char* >( TiXmlBase::SkipWhiteSpace( p, encoding ) );
+		if ( p && *p && *p != '<' )
+		{
+			// Text. Only the markup matters here.
+			p = strchr( p, '<' );
+		}
+		if ( !p || !*p )
+			return Fail( depth ? TiXmlBase::TIXML_ERROR_READING_END_TAG : TiXmlBase::TIXML_ERROR_DOCUMENT_EMPTY, 0 );
+
+		const char* start = p;
+		if ( *(p+1) == '/' )
+		{
+			if ( !depth )
+				return Fail( TiXmlBase::TIXML_ERROR_READING_END_TAG, start );
+			const char* name = openNames.c_str() + LastName();
+			const size_t length = strlen( name );
+			if ( strncmp( p+2, name, length ) != 0 )
+				return Fail( TiXmlBase::TIXML_ERROR_READING_END_TAG, start );
+			p = const_cast< char* >( TiXmlBase::SkipWhiteSpace( p + 2 + length, encoding ) );
+			if ( !p || *p != '>' )
+				return Fail( TiXmlBase::TIXML_ERROR_READING_END_TAG, start );
+			++p;
+			PopName();
+			return ELEMENT_END;
+		}
+		else if ( TiXmlBase::StringEqual( p, "<!--", false, encoding ) )
+		{
+			p = const_cast< char* >( SkipPast( p + 4, "-->" ) );
+			if ( !p )
+				return Fail( TiXmlBase::TIXML_ERROR_PARSING_COMMENT, start );
+		}
+		else if ( TiXmlBase::StringEqual( p, "<![CDATA[", false, encoding ) )
+		{
+			p = const_cast< char* >( SkipPast( p + 9, "]]>" ) );
+			if ( !p )
+				return Fail( TiXmlBase::TIXML_ERROR_PARSING_CDATA, start );
+		}
+		else if ( *(p+1) == '?' || *(p+1) == '!' )
+		{
+			p = const_cast< char* >( SkipPast( p + 2, *(p+1) == '?' ? "?>" : ">" ) );
+			if ( !p )
+				return Fail( TiXmlBase::TIXML_ERROR_PARSING_UNKNOWN, start );
+		}
+		else if (    depth > 0 && document.SkipTable()
+				  && TiXmlBase::IsSkipped( p, document.SkipTable(), encoding ) )
+		{
+			p = const_cast< char* >( TiXmlBase::SkipElement( p, encoding ) );
+			if ( !p )
+				return Fail( TiXmlBase::TIXML_ERROR_READING_END_TAG, start );
+		}
+		else
+		{
+			// Nothing of the last element is needed any more.
+			element->ClearThis();
+			document.arena.Rewind();
+
+			bool empty;
+			const char* end = element->ReadStartTag( p, data, encoding, &empty );
+			if ( !end )
+				return Fail( TiXmlBase::TIXML_ERROR_PARSING_ELEMENT, start );
+			p = const_cast< char* >( end );
+			PushName();
+			pendingEnd = empty;
+			return ELEMENT_START;
+		}
+	}
+}
+
+
+const TiXmlElement* TiXmlReader::ReadElement()
+{
+	TiXmlPaddedScan scan( padded, paddedSize );
+	if ( document.Error() )
+		return 0;
+	if ( pendingEnd )
+	{
+		pendingEnd = false;
+	}
+	else
+	{
+		const char* end = element->ReadContent( p, data, encoding );
+		if ( !end )
+		{
+			Fail( TiXmlBase::TIXML_ERROR_READING_END_TAG, p );
+			return 0;
+		}
+		p = const_cast< char* >( end );
+	}
+	PopName();
+	return element;
+}
+
+
+void TiXmlReader::SkipElement()
+{
+	TiXmlPaddedScan scan( padded, paddedSize );
+	if ( document.Error() )
+		return;
+	if ( pendingEnd )
+	{
+		pendingEnd = false;
+	}
+	else
+	{
+		const char* end = TiXmlBase::SkipElement( p, encoding, 1 );
+		if ( !end )
+		{
+			Fail( TiXmlBase::TIXML_ERROR_READING_END_TAG, p );
+			return;
+		}
+		p = const_cast< char* >( end );
+	}
+	PopName();
+}
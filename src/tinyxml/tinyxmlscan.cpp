@@ -0,0 +1,490 @@
+/*
+www.sourceforge.net/projects/tinyxml
+Original code (2.0 and earlier )copyright (c) 2000-2006 Lee Thomason (www.grinninglizard.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "tinyxml/tinyxml.h"
+
+#include <atomic>
+
+// Byte scanners for the parser. Each kernel looks at a whole 16 or 32 byte
+// aligned block at once, from the block holding the first byte to the one
+// holding the null that stops every scan. So the kernels only run inside a
+// TiXmlPaddedScan buffer, which is aligned and padded out to a whole 32
+// byte block; anywhere else the scalar loops below do the work.
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#define TIXML_SCAN_SSE2
+	#include <emmintrin.h>
+	#if defined( __GNUC__ ) || defined( __clang__ )
+		#define TIXML_SCAN_AVX2
+		#define TIXML_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+		#include <immintrin.h>
+	#elif defined( _MSC_VER )
+		#define TIXML_SCAN_AVX2
+		#define TIXML_TARGET_AVX2
+		#include <immintrin.h>
+		#include <intrin.h>
+	#endif
+#endif
+
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+	#define TIXML_SCAN_NEON
+	#include <arm_neon.h>
+#endif
+
+
+static inline bool IsAsciiSpace( char c )
+{
+	// ' ' or one of \t \n \v \f \r, which sit together at 0x09-0x0d.
+	return c == ' ' || ( c >= '\t' && c <= '\r' );
+}
+
+
+static inline bool IsTextStop( char c, char stop, int flags )
+{
+	return !c || c == '&' || c == stop
+		|| ( ( flags & TiXmlBase::SCAN_NON_ASCII ) && ( c & 0x80 ) )
+		|| ( ( flags & TiXmlBase::SCAN_WHITESPACE ) && IsAsciiSpace( c ) )
+		|| ( ( flags & TiXmlBase::SCAN_CONTROL ) && (unsigned char) c < 0x20 );
+}
+
+
+#if defined( TIXML_SCAN_SSE2 ) || defined( TIXML_SCAN_AVX2 )
+static inline int FirstSet( unsigned mask )
+{
+	#if defined( _MSC_VER ) && !defined( __clang__ )
+		unsigned long index;
+		_BitScanForward( &index, mask );
+		return (int) index;
+	#else
+		return __builtin_ctz( mask );
+	#endif
+}
+#endif
+
+
+// A whole block is tested at once, so a hit can land beyond the limit.
+static inline const char* Clamp( const char* p, const char* limit )
+{
+	return ( limit && p > limit ) ? limit : p;
+}
+
+
+static const char* ScanWhiteSpaceScalar( const char* p )
+{
+	while ( IsAsciiSpace( *p ) )
+		++p;
+	return p;
+}
+
+
+static const char* ScanTextScalar( const char* p, char stop, int flags, const char* limit )
+{
+	while ( p != limit && !IsTextStop( *p, stop, flags ) )
+		++p;
+	return p;
+}
+
+
+#ifdef TIXML_SCAN_SSE2
+static inline __m128i SpaceMaskSSE2( __m128i v )
+{
+	const __m128i shifted = _mm_sub_epi8( v, _mm_set1_epi8( '\t' ) );
+	const __m128i control = _mm_cmpeq_epi8( _mm_min_epu8( shifted, _mm_set1_epi8( '\r' - '\t' ) ), shifted );
+	return _mm_or_si128( control, _mm_cmpeq_epi8( v, _mm_set1_epi8( ' ' ) ) );
+}
+
+
+static const char* ScanWhiteSpaceSSE2( const char* p )
+{
+	const unsigned offset = (unsigned)( (size_t) p & 15 );
+	const char* block = p - offset;
+	unsigned mask = ~_mm_movemask_epi8( SpaceMaskSSE2( _mm_load_si128( (const __m128i*) block ) ) ) & ( 0xffffu << offset );
+	while ( !mask )
+	{
+		block += 16;
+		mask = ~_mm_movemask_epi8( SpaceMaskSSE2( _mm_load_si128( (const __m128i*) block ) ) ) & 0xffffu;
+	}
+	return block + FirstSet( mask );
+}
+
+
+static inline unsigned TextMaskSSE2( const char* block, char stop, int flags )
+{
+	const __m128i v = _mm_load_si128( (const __m128i*) block );
+	__m128i hit = _mm_or_si128( _mm_cmpeq_epi8( v, _mm_setzero_si128() ),
+								_mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '&' ) ),
+											  _mm_cmpeq_epi8( v, _mm_set1_epi8( stop ) ) ) );
+	if ( flags & TiXmlBase::SCAN_WHITESPACE )
+		hit = _mm_or_si128( hit, SpaceMaskSSE2( v ) );
+	if ( flags & TiXmlBase::SCAN_CONTROL )
+		hit = _mm_or_si128( hit, _mm_cmpeq_epi8( _mm_min_epu8( v, _mm_set1_epi8( 0x1f ) ), v ) );
+	unsigned mask = (unsigned) _mm_movemask_epi8( hit );
+	// The sign bits pick out everything that isn't ASCII.
+	if ( flags & TiXmlBase::SCAN_NON_ASCII )
+		mask |= (unsigned) _mm_movemask_epi8( v );
+	return mask;
+}
+
+
+static const char* ScanTextSSE2( const char* p, char stop, int flags, const char* limit )
+{
+	const unsigned offset = (unsigned)( (size_t) p & 15 );
+	const char* block = p - offset;
+	unsigned mask = TextMaskSSE2( block, stop, flags ) & ( 0xffffu << offset );
+	while ( !mask )
+	{
+		block += 16;
+		if ( limit && block >= limit )
+			return limit;
+		mask = TextMaskSSE2( block, stop, flags );
+	}
+	return Clamp( block + FirstSet( mask ), limit );
+}
+#endif
+
+
+#ifdef TIXML_SCAN_AVX2
+TIXML_TARGET_AVX2 static inline __m256i SpaceMaskAVX2( __m256i v )
+{
+	const __m256i shifted = _mm256_sub_epi8( v, _mm256_set1_epi8( '\t' ) );
+	const __m256i control = _mm256_cmpeq_epi8( _mm256_min_epu8( shifted, _mm256_set1_epi8( '\r' - '\t' ) ), shifted );
+	return _mm256_or_si256( control, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( ' ' ) ) );
+}
+
+
+TIXML_TARGET_AVX2 static const char* ScanWhiteSpaceAVX2( const char* p )
+{
+	const unsigned offset = (unsigned)( (size_t) p & 31 );
+	const char* block = p - offset;
+	unsigned mask = ~(unsigned) _mm256_movemask_epi8( SpaceMaskAVX2( _mm256_load_si256( (const __m256i*) block ) ) ) & ( ~0u << offset );
+	while ( !mask )
+	{
+		block += 32;
+		mask = ~(unsigned) _mm256_movemask_epi8( SpaceMaskAVX2( _mm256_load_si256( (const __m256i*) block ) ) );
+	}
+	return block + FirstSet( mask );
+}
+
+
+TIXML_TARGET_AVX2 static inline unsigned TextMaskAVX2( const char* block, char stop, int flags )
+{
+	const __m256i v = _mm256_load_si256( (const __m256i*) block );
+	__m256i hit = _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_setzero_si256() ),
+								   _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '&' ) ),
+													_mm256_cmpeq_epi8( v, _mm256_set1_epi8( stop ) ) ) );
+	if ( flags & TiXmlBase::SCAN_WHITESPACE )
+		hit = _mm256_or_si256( hit, SpaceMaskAVX2( v ) );
+	if ( flags & TiXmlBase::SCAN_CONTROL )
+		hit = _mm256_or_si256( hit, _mm256_cmpeq_epi8( _mm256_min_epu8( v, _mm256_set1_epi8( 0x1f ) ), v ) );
+	unsigned mask = (unsigned) _mm256_movemask_epi8( hit );
+	if ( flags & TiXmlBase::SCAN_NON_ASCII )
+		mask |= (unsigned) _mm256_movemask_epi8( v );
+	return mask;
+}
+
+
+TIXML_TARGET_AVX2 static const char* ScanTextAVX2( const char* p, char stop, int flags, const char* limit )
+{
+	const unsigned offset = (unsigned)( (size_t) p & 31 );
+	const char* block = p - offset;
+	unsigned mask = TextMaskAVX2( block, stop, flags ) & ( ~0u << offset );
+	while ( !mask )
+	{
+		block += 32;
+		if ( limit && block >= limit )
+			return limit;
+		mask = TextMaskAVX2( block, stop, flags );
+	}
+	return Clamp( block + FirstSet( mask ), limit );
+}
+
+
+static bool HasAVX2()
+{
+	#if defined( _MSC_VER ) && !defined( __clang__ )
+		// The CPU has to have it, and the OS has to save the ymm registers.
+		int info[4];
+		__cpuid( info, 0 );
+		if ( info[0] < 7 )
+			return false;
+		__cpuid( info, 1 );
+		if ( !( info[2] & ( 1 << 27 ) ) || ( _xgetbv( 0 ) & 6 ) != 6 )
+			return false;
+		__cpuidex( info, 7, 0 );
+		return ( info[1] & ( 1 << 5 ) ) != 0;
+	#else
+		return __builtin_cpu_supports( "avx2" ) != 0;
+	#endif
+}
+#endif
+
+
+#ifdef TIXML_SCAN_NEON
+// NEON has no movemask. Narrowing the compare result leaves 4 bits per byte
+// in a 64 bit lane, so the first hit is the lowest set bit over 4.
+static inline unsigned long long MaskNEON( uint8x16_t hit )
+{
+	return vget_lane_u64( vreinterpret_u64_u8( vshrn_n_u16( vreinterpretq_u16_u8( hit ), 4 ) ), 0 );
+}
+
+
+static inline int FirstSetNEON( unsigned long long mask )
+{
+	#if defined( _MSC_VER ) && !defined( __clang__ )
+		unsigned long index;
+		_BitScanForward64( &index, mask );
+		return (int) index >> 2;
+	#else
+		return __builtin_ctzll( mask ) >> 2;
+	#endif
+}
+
+
+static inline uint8x16_t SpaceMaskNEON( uint8x16_t v )
+{
+	const uint8x16_t control = vcleq_u8( vsubq_u8( v, vdupq_n_u8( '\t' ) ), vdupq_n_u8( '\r' - '\t' ) );
+	return vorrq_u8( control, vceqq_u8( v, vdupq_n_u8( ' ' ) ) );
+}
+
+
+static const char* ScanWhiteSpaceNEON( const char* p )
+{
+	const unsigned offset = (unsigned)( (size_t) p & 15 );
+	const char* block = p - offset;
+	unsigned long long mask = ~MaskNEON( SpaceMaskNEON( vld1q_u8( (const uint8_t*) block ) ) ) & ( ~0ull << ( offset * 4 ) );
+	while ( !mask )
+	{
+		block += 16;
+		mask = ~MaskNEON( SpaceMaskNEON( vld1q_u8( (const uint8_t*) block ) ) );
+	}
+	return block + FirstSetNEON( mask );
+}
+
+
+static inline unsigned long long TextMaskNEON( const char* block, char stop, int flags )
+{
+	const uint8x16_t v = vld1q_u8( (const uint8_t*) block );
+	uint8x16_t hit = vorrq_u8( vceqq_u8( v, vdupq_n_u8( 0 ) ),
+							   vorrq_u8( vceqq_u8( v, vdupq_n_u8( '&' ) ),
+										 vceqq_u8( v, vdupq_n_u8( (uint8_t) stop ) ) ) );
+	if ( flags & TiXmlBase::SCAN_NON_ASCII )
+		hit = vorrq_u8( hit, vcgeq_u8( v, vdupq_n_u8( 0x80 ) ) );
+	if ( flags & TiXmlBase::SCAN_WHITESPACE )
+		hit = vorrq_u8( hit, SpaceMaskNEON( v ) );
+	if ( flags & TiXmlBase::SCAN_CONTROL )
+		hit = vorrq_u8( hit, vcltq_u8( v, vdupq_n_u8( 0x20 ) ) );
+	return MaskNEON( hit );
+}
+
+
+static const char* ScanTextNEON( const char* p, char stop, int flags, const char* limit )
+{
+	const unsigned offset = (unsigned)( (size_t) p & 15 );
+	const char* block = p - offset;
+	unsigned long long mask = TextMaskNEON( block, stop, flags ) & ( ~0ull << ( offset * 4 ) );
+	while ( !mask )
+	{
+		block += 16;
+		if ( limit && block >= limit )
+			return limit;
+		mask = TextMaskNEON( block, stop, flags );
+	}
+	return Clamp( block + FirstSetNEON( mask ), limit );
+}
+#endif
+
+
+static bool Always()
+{
+	return true;
+}
+
+
+struct TiXmlScanKernel
+{
+	const char* name;
+	bool (*available)();
+	const char* (*whiteSpace)( const char* p );
+	const char* (*text)( const char* p, char stop, int flags, const char* limit );
+};
+
+// Best first.
+static const TiXmlScanKernel scanKernels[] =
+{
+	#ifdef TIXML_SCAN_AVX2
+	{ "avx2", HasAVX2, ScanWhiteSpaceAVX2, ScanTextAVX2 },
+	#endif
+	#ifdef TIXML_SCAN_SSE2
+	{ "sse2", Always, ScanWhiteSpaceSSE2, ScanTextSSE2 },
+	#endif
+	#ifdef TIXML_SCAN_NEON
+	{ "neon", Always, ScanWhiteSpaceNEON, ScanTextNEON },
+	#endif
+	{ "scalar", Always, ScanWhiteSpaceScalar, ScanTextScalar }
+};
+
+
+static const TiXmlScanKernel* BestScanKernel()
+{
+	const TiXmlScanKernel* kernel = scanKernels;
+	while ( !kernel->available() )
+		++kernel;
+	return kernel;
+}
+
+
+// Every parse reads this and SetScanKernel() may write it at any time, from
+// any thread. The kernels are constant tables, so a relaxed load is enough:
+// a parse that races a switch uses one kernel or the other, both correct.
+static std::atomic<const TiXmlScanKernel*>& ScanKernelSlot()
+{
+	// Picked once, on first use, by whichever thread gets here first.
+	static std::atomic<const TiXmlScanKernel*> kernel( BestScanKernel() );
+	return kernel;
+}
+
+
+static const TiXmlScanKernel* ScanKernelInUse()
+{
+	return ScanKernelSlot().load( std::memory_order_relaxed );
+}
+
+
+// The innermost padded buffer on this thread, if any.
+static thread_local const TiXmlPaddedScan* paddedScan = 0;
+
+
+TiXmlPaddedScan::TiXmlPaddedScan( const char* buffer, size_t size )
+	: begin( buffer ), end( buffer + size ), outer( paddedScan )
+{
+	assert( size == 0 || ( ( (size_t) buffer & ( ALIGN - 1 ) ) == 0 && ( size & ( ALIGN - 1 ) ) == 0 ) );
+	paddedScan = this;
+}
+
+
+TiXmlPaddedScan::~TiXmlPaddedScan()
+{
+	paddedScan = outer;
+}
+
+
+bool TiXmlPaddedScan::Covers( const char* p )
+{
+	// Compared as addresses: p needn't be in the buffer at all.
+	const TiXmlPaddedScan* scan = paddedScan;
+	return scan && (size_t) p >= (size_t) scan->begin && (size_t) p < (size_t) scan->end;
+}
+
+
+const char* TiXmlBase::ScanKernel()
+{
+	return ScanKernelInUse()->name;
+}
+
+
+bool TiXmlBase::SetScanKernel( const char* name )
+{
+	for( size_t i=0; i<sizeof( scanKernels ) / sizeof( scanKernels[0] ); ++i )
+	{
+		if ( strcmp( scanKernels[i].name, name ) == 0 && scanKernels[i].available() )
+		{
+			ScanKernelSlot().store( &scanKernels[i], std::memory_order_relaxed );
+			return true;
+		}
+	}
+	return false;
+}
+
+
+const char* TiXmlBase::ScanWhiteSpace( const char* p )
+{
+	// Most runs are a single space between attributes; don't pay for a
+	// vector load to find that out.
+	if ( !IsAsciiSpace( p[0] ) )
+		return p;
+	if ( !IsAsciiSpace( p[1] ) )
+		return p + 1;
+	if ( !TiXmlPaddedScan::Covers( p ) )
+		return ScanWhiteSpaceScalar( p + 2 );
+	return ScanKernelInUse()->whiteSpace( p + 2 );
+}
+
+
+const char* TiXmlBase::ScanText( const char* p, char stop, int flags, const char* limit )
+{
+	if ( p == limit || IsTextStop( *p, stop, flags ) )
+		return p;
+	if ( !TiXmlPaddedScan::Covers( p ) )
+		return ScanTextScalar( p + 1, stop, flags, limit );
+	return ScanKernelInUse()->text( p + 1, stop, flags, limit );
+}
+
+
+bool TiXmlBase::IsValidUTF8( const char* p )
+{
+	// ASCII goes by a block at a time; each multi-byte sequence is checked
+	// as in RFC 3629: no overlong forms, no surrogates, nothing past U+10FFFF.
+	for( ;; )
+	{
+		p = ScanText( p, 0, SCAN_NON_ASCII );
+		const unsigned char* u = (const unsigned char*) p;
+		if ( *u == 0 )
+			return true;
+		if ( *u == '&' )
+		{
+			++p;
+			continue;
+		}
+
+		int length;
+		if ( u[0] < 0xc2 )
+			return false;
+		else if ( u[0] < 0xe0 )
+			length = 2;
+		else if ( u[0] < 0xf0 )
+		{
+			if (    ( u[0] == 0xe0 && u[1] < 0xa0 )
+				 || ( u[0] == 0xed && u[1] >= 0xa0 ) )
+				return false;
+			length = 3;
+		}
+		else if ( u[0] < 0xf5 )
+		{
+			if (    ( u[0] == 0xf0 && u[1] < 0x90 )
+				 || ( u[0] == 0xf4 && u[1] >= 0x90 ) )
+				return false;
+			length = 4;
+		}
+		else
+			return false;
+
+		// A null ends the loop early, on a byte that isn't a continuation.
+		for( int i=1; i<length; ++i )
+		{
+			if ( ( u[i] & 0xc0 ) != 0x80 )
+				return false;
+		}
+		p += length;
+	}
+}